@@ -114,6 +114,7 @@ class NetworkInterfaceAdapter : public TCPOverIPv4Adapter {
         _interface.tick(ms_since_last_tick);
         send_pending();
     }
+    optional<size_t> time_until_next_timer() const { return _interface.time_until_next_timer(); }
     NetworkInterface &interface() { return _interface; }
     queue<EthernetFrame> frames_out() { return _interface.frames_out(); }
 
@@ -1,9 +1,14 @@
 #include "tcp_connection.hh"
+#include "tcp_segment_coalescer.hh"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
+#include <deque>
 #include <iomanip>
 #include <iostream>
+#include <optional>
+#include <random>
 #include <string>
 
 using namespace std;
@@ -11,26 +16,57 @@ using namespace std::chrono;
 
 constexpr size_t len = 100 * 1024 * 1024;
 
-void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
+void move_segments(TCPConnection &x,
+                   TCPConnection &y,
+                   vector<TCPSegment> &segments,
+                   const bool reorder,
+                   TCPSegmentCoalescer *coalescer = nullptr) {
     while (not x.segments_out().empty()) {
-        segments.emplace_back(move(x.segments_out().front()));
+        // split super-segments as an adapter would
+        if (x.segments_out().front().gso_size() > 0) {
+            for (auto &wire_seg : x.segments_out().front().wire_segments()) {
+                segments.emplace_back(move(wire_seg));
+            }
+        } else {
+            segments.emplace_back(move(x.segments_out().front()));
+        }
         x.segments_out().pop();
     }
     if (reorder) {
-        for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
-            y.segment_received(move(*it));
+        reverse(segments.begin(), segments.end());
+    }
+    // merge each burst as a receive offload stage would
+    if (coalescer) {
+        for (auto &seg : segments) {
+            coalescer->push(move(seg));
         }
-    } else {
-        for (auto it = segments.begin(); it != segments.end(); ++it) {
-            y.segment_received(move(*it));
+        coalescer->flush();
+        segments.clear();
+        for (; not coalescer->segments_out().empty(); coalescer->segments_out().pop()) {
+            segments.emplace_back(move(coalescer->segments_out().front()));
         }
     }
+    for (auto &seg : segments) {
+        y.segment_received(move(seg));
+    }
     segments.clear();
 }
 
-void main_loop(const bool reorder) {
+void main_loop(const bool reorder,
+               const bool ring_reassembly = false,
+               const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE,
+               const bool segmentation_offload = false,
+               const bool receive_offload = false) {
     TCPConfig config;
+    config.ring_reassembly = ring_reassembly;
+    config.mss = mss;
+    config.segmentation_offload = segmentation_offload;
+    config.receive_offload = receive_offload;
     TCPConnection x{config}, y{config};
+    optional<TCPSegmentCoalescer> coalescer{};
+    if (receive_offload) {
+        coalescer.emplace();
+    }
 
     string string_to_send(len, 'x');
     for (auto &ch : string_to_send) {
@@ -66,13 +102,16 @@ void main_loop(const bool reorder) {
 
         // exchange segments between x and y but in reverse order
         vector<TCPSegment> segments;
-        move_segments(x, y, segments, reorder);
+        move_segments(x, y, segments, reorder, coalescer ? &coalescer.value() : nullptr);
         move_segments(y, x, segments, false);
 
         // read output from y
         const auto available_output = y.inbound_stream().buffer_size();
         if (available_output > 0) {
-            string_received.append(y.inbound_stream().read(available_output));
+            const size_t offset = string_received.size();
+            string_received.resize(offset + available_output);
+            const iovec dest{string_received.data() + offset, available_output};
+            y.inbound_stream().read_into(&dest, 1);
         }
 
         // time passes
@@ -95,18 +134,140 @@ void main_loop(const bool reorder) {
     const auto gigabits_per_second = len * 8.0 / double(duration);
 
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+    const string label = string("CPU-limited throughput") + (reorder ? " with reordering" : "") +
+                         (ring_reassembly ? " (ring reassembly)" : "") +
+                         (mss != TCPConfig::MAX_PAYLOAD_SIZE ? " (MSS " + to_string(mss) + ")" : "") +
+                         (segmentation_offload ? " (GSO)" : "") + (receive_offload ? " (GRO)" : "");
+    cout << left << setw(56) << label << ": " << gigabits_per_second << " Gbit/s\n";
 
     while (x.active() or y.active()) {
         loop();
     }
 }
 
+//! \brief One direction of a simulated bottleneck link
+//! \details Segments are serialized at `bytes_per_ms`, wait in a drop-tail queue holding at most
+//! `queue_ms` worth of data, are lost at random with probability `loss_rate`, and arrive
+//! `delay_ms` after they finish serializing.
+class SimulatedLink {
+    struct Transit {
+        uint64_t deliver_at;
+        TCPSegment seg;
+    };
+
+    uint64_t _delay_ms;
+    uint64_t _bytes_per_ms;
+    uint64_t _queue_ms;
+    bernoulli_distribution _loss;
+    mt19937 _rng{144};
+    deque<Transit> _transit{};
+    double _free_at = 0;
+
+  public:
+    SimulatedLink(const uint64_t delay_ms, const uint64_t bytes_per_ms, const uint64_t queue_ms, const double loss_rate)
+        : _delay_ms(delay_ms), _bytes_per_ms(bytes_per_ms), _queue_ms(queue_ms), _loss(loss_rate) {}
+
+    void send(TCPSegment &&seg, const uint64_t now) {
+        for (auto &wire_seg : seg.wire_segments()) {
+            _free_at = max(_free_at, double(now));
+            if (_free_at > now + _queue_ms or _loss(_rng)) {
+                continue;
+            }
+            _free_at += double(wire_seg.payload().size() + 40) / _bytes_per_ms;
+            _transit.push_back({uint64_t(_free_at) + _delay_ms, move(wire_seg)});
+        }
+    }
+
+    void deliver(TCPConnection &receiver, const uint64_t now) {
+        while (not _transit.empty() and _transit.front().deliver_at <= now) {
+            receiver.segment_received(_transit.front().seg);
+            _transit.pop_front();
+        }
+    }
+};
+
+void lossy_link_loop(const TCPConfig::CongestionControl algorithm, const string &name) {
+    constexpr uint64_t one_way_delay_ms = 50;
+    constexpr uint64_t bytes_per_ms = 1250;  // 10 Mbit/s
+    constexpr double loss_rate = 0.01;
+    constexpr uint64_t simulated_ms = 60'000;
+    constexpr size_t window_bytes = 1'000'000;  // well past the bandwidth-delay product
+
+    TCPConfig config;
+    config.congestion_control = algorithm;
+    config.rtt_estimation = true;
+    config.sack = true;
+    config.window_scaling = true;
+    config.timestamps = true;
+    config.delayed_ack_ms = 40;
+    config.recv_capacity = window_bytes;
+    config.send_capacity = window_bytes;
+    TCPConnection x{config}, y{config};
+    SimulatedLink uplink{one_way_delay_ms, bytes_per_ms, 2 * one_way_delay_ms, loss_rate};
+    SimulatedLink downlink{one_way_delay_ms, bytes_per_ms, 2 * one_way_delay_ms, 0};
+
+    uint64_t delivered = 0;
+    uint64_t data_segments = 0, acks = 0;
+    const auto step = [&](const uint64_t now) {
+        while (not x.segments_out().empty()) {
+            data_segments++;
+            uplink.send(move(x.segments_out().front()), now);
+            x.segments_out().pop();
+        }
+        while (not y.segments_out().empty()) {
+            acks++;
+            downlink.send(move(y.segments_out().front()), now);
+            y.segments_out().pop();
+        }
+        uplink.deliver(y, now);
+        downlink.deliver(x, now);
+
+        delivered += y.inbound_stream().buffer_size();
+        y.inbound_stream().pop_output(y.inbound_stream().buffer_size());
+
+        x.tick(1);
+        y.tick(1);
+    };
+
+    x.connect();
+    uint64_t now = 0;
+    for (; now < simulated_ms and x.active(); ++now) {
+        if (x.remaining_outbound_capacity() > 0) {
+            x.write(string(x.remaining_outbound_capacity(), 'x'));
+        }
+        step(now);
+    }
+    const uint64_t measured = delivered;
+    const auto acks_per_segment = double(acks) / double(data_segments);
+
+    // close both directions so the connections shut down cleanly
+    x.end_input_stream();
+    y.end_input_stream();
+    for (; x.active() or y.active(); ++now) {
+        step(now);
+    }
+
+    const auto megabits_per_second = measured * 8.0 / double(simulated_ms * 1000);
+    cout << fixed << setprecision(2);
+    const string label = "Goodput, 100 ms RTT, 1% loss, 10 Mbit/s (" + name + ")";
+    cout << left << setw(56) << label << ": " << megabits_per_second << " Mbit/s";
+    cout << " (" << x.fast_retransmissions() << " fast retransmissions, " << x.timeout_retransmissions()
+         << " timeouts, " << acks_per_segment << " ACKs per segment)\n";
+}
+
 int main() {
     try {
         main_loop(false);
         main_loop(true);
+        main_loop(false, true);
+        main_loop(true, true);
+        main_loop(false, false, 1460);
+        main_loop(false, false, 1460, true);
+        main_loop(false, false, 1460, true, true);
+        lossy_link_loop(TCPConfig::CongestionControl::None, "none");
+        lossy_link_loop(TCPConfig::CongestionControl::NewReno, "newreno");
+        lossy_link_loop(TCPConfig::CongestionControl::Cubic, "cubic");
+        lossy_link_loop(TCPConfig::CongestionControl::Bbr, "bbr");
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
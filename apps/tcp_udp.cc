@@ -1,4 +1,5 @@
 #include "bidirectional_stream_copy.hh"
+#include "congestion_controller.hh"
 #include "tcp_config.hh"
 #include "tcp_sponge_socket.hh"
 
@@ -24,9 +25,27 @@ static void show_usage(const char *argv0, const char *msg) {
          << "                   In server mode, <host>:<port> is the address to bind.\n\n"
 
          << "   -w <winsz>      Use a window of <winsz> bytes                   " << TCPConfig::MAX_PAYLOAD_SIZE
+         << "\n"
+         << "   -m <mss>        Send at most <mss> payload bytes per segment    " << TCPConfig::MAX_PAYLOAD_SIZE
          << "\n\n"
 
-         << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
+         << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n"
+         << "   -r              Estimate the RTT and adapt the timeout to it    (fixed timeout)\n"
+         << "   -S              Negotiate selective acknowledgments (SACK)      (off)\n"
+         << "   -W              Negotiate window scaling, for windows > 64 KiB  (off)\n"
+         << "   -T              Negotiate timestamps, for RTT samples and PAWS  (off)\n"
+         << "   -D <ms>         Delay ACKs of in-order data by up to <ms>       (off)\n"
+         << "   -G              Send 64 KiB segments for the adapter to split   (off)\n"
+         << "   -g              Coalesce bursts of received segments (GRO)      (off)\n"
+         << "   -N              Hold small writes while data is unacked (Nagle) (off)\n"
+         << "   -K              Send only full segments for up to " << TCPConfig::CORK_TIMEOUT_MS
+         << " ms (cork) (off)\n"
+         << "   -P              Back off zero-window probes (persist timer)     (off)\n"
+         << "   -A              Autotune the receive buffer                     (off)\n"
+         << "   -B              Autotune the send buffer                        (off)\n"
+         << "   -C              Merge small segments when retransmitting        (off)\n\n"
+
+         << "   -c <algo>       Congestion control: none, newreno, cubic, bbr   none\n\n"
 
          << "   -Lu <loss>      Set uplink loss to <rate> (float in 0..1)       (no loss)\n"
          << "   -Ld <loss>      Set downlink loss to <rate> (float in 0..1)     (no loss)\n\n"
@@ -63,11 +82,83 @@ static tuple<TCPConfig, FdAdapterConfig, bool> get_config(int argc, char **argv)
             c_fsm.recv_capacity = strtol(argv[curr + 1], nullptr, 0);
             curr += 2;
 
+        } else if (strncmp("-m", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -m requires one argument.");
+            c_fsm.mss = strtol(argv[curr + 1], nullptr, 0);
+            if (c_fsm.mss == 0) {
+                show_usage(argv[0], "ERROR: -m requires a positive number of bytes.");
+                exit(1);
+            }
+            curr += 2;
+
         } else if (strncmp("-t", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -t requires one argument.");
             c_fsm.rt_timeout = strtol(argv[curr + 1], nullptr, 0);
             curr += 2;
 
+        } else if (strncmp("-r", argv[curr], 3) == 0) {
+            c_fsm.rtt_estimation = true;
+            curr += 1;
+
+        } else if (strncmp("-S", argv[curr], 3) == 0) {
+            c_fsm.sack = true;
+            curr += 1;
+
+        } else if (strncmp("-W", argv[curr], 3) == 0) {
+            c_fsm.window_scaling = true;
+            curr += 1;
+
+        } else if (strncmp("-T", argv[curr], 3) == 0) {
+            c_fsm.timestamps = true;
+            curr += 1;
+
+        } else if (strncmp("-D", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -D requires one argument.");
+            c_fsm.delayed_ack_ms = strtol(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-G", argv[curr], 3) == 0) {
+            c_fsm.segmentation_offload = true;
+            curr += 1;
+
+        } else if (strncmp("-g", argv[curr], 3) == 0) {
+            c_fsm.receive_offload = true;
+            curr += 1;
+
+        } else if (strncmp("-N", argv[curr], 3) == 0) {
+            c_fsm.nagle = true;
+            curr += 1;
+
+        } else if (strncmp("-K", argv[curr], 3) == 0) {
+            c_fsm.cork = true;
+            curr += 1;
+
+        } else if (strncmp("-P", argv[curr], 3) == 0) {
+            c_fsm.persist_timer = true;
+            curr += 1;
+
+        } else if (strncmp("-A", argv[curr], 3) == 0) {
+            c_fsm.recv_autotuning = true;
+            curr += 1;
+
+        } else if (strncmp("-B", argv[curr], 3) == 0) {
+            c_fsm.send_autotuning = true;
+            curr += 1;
+
+        } else if (strncmp("-C", argv[curr], 3) == 0) {
+            c_fsm.retransmit_collapse = true;
+            curr += 1;
+
+        } else if (strncmp("-c", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -c requires one argument.");
+            const auto algorithm = congestion_control_from_name(argv[curr + 1]);
+            if (not algorithm.has_value()) {
+                show_usage(argv[0], "ERROR: unknown congestion control algorithm.");
+                exit(1);
+            }
+            c_fsm.congestion_control = algorithm.value();
+            curr += 2;
+
         } else if (strncmp("-Lu", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -Lu requires one argument.");
             float lossrate = strtof(argv[curr + 1], nullptr);
@@ -1,12 +1,14 @@
 #include "socket.hh"
 
 #include "address.hh"
+#include "byte_stream.hh"
 #include "util.hh"
 
 #include <array>
 #include <cstdlib>
 #include <random>
 #include <stdexcept>
+#include <string>
 #include <sys/socket.h>
 #include <vector>
 
@@ -18,6 +20,42 @@ int main() {
 #include "socket_example_2.cc"
         } {
 #include "socket_example_3.cc"
+        } {
+            // TCPSpongeSocket drains its inbound stream into the app's pipe with ByteStream::read_into.
+            // With a small send buffer the gather write comes up short, and only what it took may be popped.
+            std::array<int, 2> fds{};
+            SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()));
+            LocalStreamSocket pipe1{FileDescriptor(fds[0])}, pipe2{FileDescriptor(fds[1])};
+            pipe1.set_blocking(false);
+            const int sndbuf = 4096;
+            SystemCall("setsockopt", ::setsockopt(pipe1.fd_num(), SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf)));
+
+            // leave the readable bytes wrapping around the end of the stream's storage
+            ByteStream stream(65536);
+            stream.write(std::string(1000, 0));
+            stream.pop_output(1000);
+            auto rd = get_random_generator();
+            std::string sent(65536, 0);
+            for (auto &ch : sent) {
+                ch = static_cast<char>(rd());
+            }
+            stream.write(sent);
+
+            const size_t first = stream.read_into(pipe1, stream.buffer_size());
+            if (first == 0 or first == sent.size() or stream.buffer_size() != sent.size() - first) {
+                throw std::runtime_error("a short write should pop exactly the bytes written");
+            }
+
+            std::string recvd;
+            while (recvd.size() < sent.size()) {
+                recvd += pipe2.read();
+                if (not stream.buffer_empty()) {
+                    stream.read_into(pipe1, stream.buffer_size());
+                }
+            }
+            if (recvd != sent or not stream.buffer_empty()) {
+                throw std::runtime_error("bytes lost or repeated across short writes");
+            }
         }
     } catch (...) {
         return EXIT_FAILURE;
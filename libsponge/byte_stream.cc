@@ -1,5 +1,8 @@
 #include "byte_stream.hh"
 
+#include <algorithm>
+#include <cstring>
+
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
 // For Lab 0, please replace with a real implementation that passes the
@@ -12,31 +15,115 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
+//! \returns the smallest power of two that can hold `capacity` bytes (at least one)
+static size_t ring_size_for(const size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    return size;
+}
+
 ByteStream::ByteStream(const size_t capacity)
-    : _buffer(), _capacity(capacity), _write_bytes(0), _read_bytes(0), _input_ended(false) {}
+    : _buffer(ring_size_for(capacity))
+    , _mask(_buffer.size() - 1)
+    , _capacity(capacity)
+    , _write_bytes(0)
+    , _read_bytes(0)
+    , _input_ended(false) {}
+
+//! \param[in] capacity the new capacity; the ring is reallocated if it needs a different power-of-two size
+void ByteStream::set_capacity(const size_t capacity) {
+    const size_t new_capacity = max(capacity, buffer_size());
+    const size_t size = ring_size_for(new_capacity);
+    if (size != _buffer.size()) {
+        //! Stream index `i` lives at `i & mask` in either ring; copy the readable and staged bytes across.
+        vector<char> buffer(size);
+        const size_t keep = min(_capacity, new_capacity);
+        for (size_t done = 0; done < keep;) {
+            const size_t from = (_read_bytes + done) & _mask;
+            const size_t to = (_read_bytes + done) & (size - 1);
+            const size_t length = min({keep - done, _buffer.size() - from, size - to});
+            memcpy(buffer.data() + to, _buffer.data() + from, length);
+            done += length;
+        }
+        _buffer = move(buffer);
+        _mask = size - 1;
+    }
+    _capacity = new_capacity;
+}
 
-size_t ByteStream::write(const string &data) {
-    size_t length = min(remaining_capacity(), data.size());
-    for (size_t i = 0; i < length; ++i) {
-        _buffer.emplace_back(data[i]);
+size_t ByteStream::write(const string &data) { return _write_ring(data); }
+
+size_t ByteStream::write(const BufferList &data) {
+    size_t length = 0;
+    for (const auto &buffer : data.buffers()) {
+        const size_t written = _write_ring(buffer);
+        length += written;
+        if (written < buffer.size()) {
+            break;
+        }
     }
+    return length;
+}
+
+size_t ByteStream::_write_ring(const string_view data) {
+    const size_t length = stage(0, data);
     _write_bytes += length;
     return length;
 }
 
+//! \param[in] offset the distance past the input side at which `data` starts
+//! \param[in] data bytes to place in the storage; anything beyond the remaining capacity is dropped
+//! \returns the number of bytes staged
+size_t ByteStream::stage(const size_t offset, const string_view data) {
+    if (offset >= remaining_capacity()) {
+        return 0;
+    }
+    const size_t length = min(remaining_capacity() - offset, data.size());
+    if (length == 0) {
+        return 0;
+    }
+    const size_t begin = (_write_bytes + offset) & _mask;
+    const size_t first = min(length, _buffer.size() - begin);
+    memcpy(_buffer.data() + begin, data.data(), first);
+    memcpy(_buffer.data(), data.data() + first, length - first);
+    return length;
+}
+
+//! \param[in] len the number of staged bytes, starting at the input side, that become readable
+void ByteStream::commit(const size_t len) { _write_bytes += min(len, remaining_capacity()); }
+
 //! \param[in] len bytes will be copied from the output side of the buffer
 //! \note The peek length can't exceed buffer size.
 string ByteStream::peek_output(const size_t len) const {
-    return {_buffer.begin(), _buffer.begin() + min(len, buffer_size())};
+    const auto views = peek_output_views(len);
+    string s;
+    s.reserve(views.first.size() + views.second.size());
+    s.append(views.first).append(views.second);
+    return s;
 }
 
-//! \param[in] len bytes will be removed from the output side of the buffer
-void ByteStream::pop_output(const size_t len) {
-    size_t length = min(len, buffer_size());
-    _buffer.erase(_buffer.begin(), _buffer.begin() + length);
-    _read_bytes += length;
+//! \param[in] len bytes will be exposed from the output side of the buffer
+//! \note The views are invalidated by the next write or pop.
+pair<string_view, string_view> ByteStream::peek_output_views(const size_t len) const {
+    const size_t length = min(len, buffer_size());
+    const size_t begin = _read_bytes & _mask;
+    const size_t first = min(length, _buffer.size() - begin);
+    return {{_buffer.data() + begin, first}, {_buffer.data(), length - first}};
 }
 
+//! \param[in] len bytes will be exposed from the output side of the buffer
+BufferViewList ByteStream::peek_buffers(const size_t len) const {
+    const auto views = peek_output_views(len);
+    BufferViewList buffers{views.first};
+    buffers.append(views.second);
+    return buffers;
+}
+
+//! \param[in] len bytes will be removed from the output side of the buffer
+void ByteStream::pop_output(const size_t len) { _read_bytes += min(len, buffer_size()); }
+
 //! Read (i.e., copy and then pop) the next "len" bytes of the stream
 //! \param[in] len bytes will be popped and returned
 //! \returns a string
@@ -46,13 +133,41 @@ std::string ByteStream::read(const size_t len) {
     return s;
 }
 
+//! \param[in] iov the destination regions, filled in order until the stream or the regions run out
+//! \param[in] iovcnt the number of entries in `iov`
+//! \returns the number of bytes copied and popped
+size_t ByteStream::read_into(const iovec *iov, const size_t iovcnt) {
+    size_t length = 0;
+    for (size_t i = 0; i < iovcnt and not buffer_empty(); ++i) {
+        if (iov[i].iov_len == 0) {
+            continue;
+        }
+        char *dest = static_cast<char *>(iov[i].iov_base);
+        const auto views = peek_output_views(iov[i].iov_len);
+        memcpy(dest, views.first.data(), views.first.size());
+        memcpy(dest + views.first.size(), views.second.data(), views.second.size());
+        const size_t copied = views.first.size() + views.second.size();
+        pop_output(copied);
+        length += copied;
+    }
+    return length;
+}
+
+//! \param[in] fd the destination, which may take fewer bytes than offered (e.g. when it is non-blocking)
+//! \param[in] len the most bytes to offer, in one [writev(2)](\ref man2::writev)
+size_t ByteStream::read_into(FileDescriptor &fd, const size_t len) {
+    const size_t length = fd.write(peek_buffers(len), false);
+    pop_output(length);
+    return length;
+}
+
 void ByteStream::end_input() { _input_ended = true; }
 
 bool ByteStream::input_ended() const { return _input_ended; }
 
-size_t ByteStream::buffer_size() const { return _buffer.size(); }
+size_t ByteStream::buffer_size() const { return _write_bytes - _read_bytes; }
 
-bool ByteStream::buffer_empty() const { return _buffer.empty(); }
+bool ByteStream::buffer_empty() const { return buffer_size() == 0; }
 
 bool ByteStream::eof() const { return input_ended() && buffer_empty(); }
 
@@ -1,8 +1,13 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
-#include <deque>
+#include "buffer.hh"
+#include "file_descriptor.hh"
+
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
@@ -19,13 +24,17 @@ class ByteStream {
     // all, but if any of your tests are taking longer than a second,
     // that's a sign that you probably want to keep exploring
     // different approaches.
-    std::deque<char> _buffer;  //!< The buffer of the stream. The deque front is the output size,
-                               //!< The deque back is the input size.
-    size_t _capacity;          //!< The capacity of the stream.
-    size_t _write_bytes;       //!< The written bytes of the stream.
-    size_t _read_bytes;        //!< The read bytes of the stream.
-    bool _input_ended;         //!< Whether the input ended.
-    bool _error{};             //!< Flag indicating that the stream suffered an error.
+    std::vector<char> _buffer;  //!< The ring storage of the stream, sized to a power of two >= `_capacity`.
+    size_t _mask;               //!< `_buffer.size() - 1`, maps a stream index to its slot in `_buffer`.
+    size_t _capacity;           //!< The capacity of the stream.
+    size_t _write_bytes;        //!< The written bytes of the stream, also the input index of the ring.
+    size_t _read_bytes;         //!< The read bytes of the stream, also the output index of the ring.
+    bool _input_ended;          //!< Whether the input ended.
+    bool _error{};              //!< Flag indicating that the stream suffered an error.
+
+    //! Copy as much of `data` as fits into the ring at the input side (at most two `memcpy`s).
+    //! \returns the number of bytes accepted into the stream
+    size_t _write_ring(std::string_view data);
 
   public:
     //! Construct a stream with room for `capacity` bytes.
@@ -39,9 +48,33 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write the bytes of a shared Buffer, copying straight from its storage into the stream
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const Buffer &data) { return _write_ring(data); }
+
+    //! Write the bytes of a discontiguous BufferList, one slice at a time
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const BufferList &data);
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
+    //! \returns the most bytes the stream holds at once
+    size_t capacity() const { return _capacity; }
+
+    //! \brief Grow or shrink the stream, to no less than what it holds now
+    //! \details Bytes staged past the input side (see stage()) are kept, as far as they fit.
+    void set_capacity(const size_t capacity);
+
+    //! \brief Copy bytes into the storage past the input side without making them readable yet
+    //! \details Lets an out-of-order writer (e.g. the StreamReassembler) place bytes where they
+    //! will eventually live; commit() later exposes them to the reader without another copy.
+    //! \returns the number of bytes staged
+    size_t stage(const size_t offset, std::string_view data);
+
+    //! Make the next `len` staged bytes readable, as if they had just been written
+    void commit(const size_t len);
+
     //! Signal that the byte stream has reached its ending
     void end_input();
 
@@ -56,6 +89,15 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying
+    //! \returns the (at most two) contiguous regions of the ring, in stream order;
+    //! the second view is empty unless the bytes wrap around the end of the storage
+    std::pair<std::string_view, std::string_view> peek_output_views(const size_t len) const;
+
+    //! Peek at next "len" bytes of the stream as a non-owning BufferViewList
+    //! \note Suitable for [writev(2)](\ref man2::writev) via FileDescriptor::write; valid until the next write or pop.
+    BufferViewList peek_buffers(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
@@ -63,6 +105,17 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Read (i.e., scatter-copy and then pop) the next bytes of the stream into caller-owned storage
+    //! \param iov the destination regions, filled in order
+    //! \param iovcnt the number of entries in `iov`
+    //! \returns the number of bytes copied and popped
+    size_t read_into(const iovec *iov, const size_t iovcnt);
+
+    //! Read (i.e., gather-write and then pop) up to "len" bytes of the stream into a file descriptor
+    //! \note Only what `fd` accepts is popped; after a short write, the rest waits for the next call.
+    //! \returns the number of bytes written and popped
+    size_t read_into(FileDescriptor &fd, const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
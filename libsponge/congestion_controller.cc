@@ -0,0 +1,377 @@
+#include "congestion_controller.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+using namespace std;
+
+//! \param[in] mss the sender maximum segment size, in bytes
+NewReno::NewReno(const uint64_t mss) : _mss(mss), _cwnd(INITIAL_WINDOW_SEGMENTS * mss) {}
+
+void NewReno::_congestion_avoidance(const uint64_t acked_bytes) {
+    _bytes_acked += acked_bytes;
+    if (_bytes_acked >= _cwnd) {
+        _bytes_acked -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+uint64_t NewReno::_reduce(const uint64_t bytes_in_flight) { return max(bytes_in_flight / 2, 2 * _mss); }
+
+bool NewReno::on_ack(const uint64_t ackno, const uint64_t acked_bytes, const uint64_t bytes_in_flight) {
+    if (_in_recovery) {
+        //! A full ACK covers everything outstanding when the loss was detected: deflate the window.
+        if (ackno >= _recover) {
+            _in_recovery = false;
+            _sack_recovery = false;
+            _cwnd = min(_ssthresh, max(bytes_in_flight, _mss) + _mss);
+            return false;
+        }
+
+        //! A partial ACK means the next hole is lost too: retransmit it and stay in recovery.
+        //! Only an inflated window needs deflating by what left the network.
+        if (_sack_recovery) {
+            return true;
+        }
+        _cwnd -= min(_cwnd, acked_bytes);
+        if (acked_bytes >= _mss) {
+            _cwnd += _mss;
+        }
+        return true;
+    }
+
+    if (_cwnd < _ssthresh) {
+        //! Slow start: grow by at most one segment per ACK (appropriate byte counting, L = 1).
+        _cwnd += min(acked_bytes, _mss);
+    } else {
+        _congestion_avoidance(acked_bytes);
+    }
+    return false;
+}
+
+bool NewReno::on_duplicate_ack(const uint64_t ackno,
+                               const unsigned dup_acks,
+                               const uint64_t next_seqno,
+                               const uint64_t bytes_in_flight) {
+    if (_in_recovery) {
+        //! Each further duplicate means another segment has left the network.
+        if (!_sack_recovery) {
+            _cwnd += _mss;
+        }
+        return false;
+    }
+
+    //! Don't start another recovery for losses in the window we already recovered from.
+    if (dup_acks != TCPConfig::DUP_ACK_THRESHOLD || ackno <= _recover) {
+        return false;
+    }
+
+    _ssthresh = _reduce(bytes_in_flight);
+    _cwnd = _ssthresh + TCPConfig::DUP_ACK_THRESHOLD * _mss;
+    _bytes_acked = 0;
+    _recover = next_seqno;
+    _in_recovery = true;
+    return true;
+}
+
+//! \details Recovery starts as on the third duplicate ACK, but cwnd is set to ssthresh rather than
+//! inflated: the pipe already leaves out the segments the receiver SACKed (RFC 6675 section 5, step 4.2).
+bool NewReno::on_sack_loss(const uint64_t ackno, const uint64_t next_seqno, const uint64_t bytes_in_flight) {
+    if (_in_recovery || ackno <= _recover) {
+        return false;
+    }
+
+    _ssthresh = _reduce(bytes_in_flight);
+    _cwnd = _ssthresh;
+    _bytes_acked = 0;
+    _recover = next_seqno;
+    _in_recovery = true;
+    _sack_recovery = true;
+    return true;
+}
+
+//! \details Everything sent so far is resent after a timeout, so the duplicate ACKs it brings must not
+//! start a fast retransmit (and a second reduction) for the same losses (RFC 6582 section 3.2, step 4).
+void NewReno::on_timeout(const uint64_t next_seqno, const uint64_t bytes_in_flight) {
+    _ssthresh = _reduce(bytes_in_flight);
+    _cwnd = _mss;
+    _bytes_acked = 0;
+    _in_recovery = false;
+    _sack_recovery = false;
+    _recover = next_seqno;
+}
+
+//! \details Follows the window of RFC 8312 section 4: the cubic function W(t + RTT)
+//! when it is ahead of the standard-TCP estimate W_est, and W_est otherwise (the
+//! "TCP-friendly region"). W_est grows by alpha = 3 * (1 - beta) / (1 + beta)
+//! segments per window of acknowledged data, which gives the same average rate as
+//! Reno with its 0.5 decrease.
+void Cubic::_congestion_avoidance(const uint64_t acked_bytes) {
+    const double mss = _mss;
+    const double cwnd = _cwnd / mss;
+    const double acked = acked_bytes / mss;
+
+    if (not _epoch_start_ms.has_value()) {
+        _epoch_start_ms = _now_ms;
+        _k = cwnd < _w_max ? cbrt((_w_max - cwnd) / C) : 0;
+        _w_max = max(_w_max, cwnd);
+        _w_est = cwnd;
+    }
+
+    //! Aim for where W(t) will be one RTT from now, when this ACK's data is acknowledged.
+    const double t = (_now_ms + _rtt_ms - _epoch_start_ms.value()) / 1000.0;
+    const double w_cubic = C * pow(t - _k, 3) + _w_max;
+    _w_est += 3 * (1 - BETA) / (1 + BETA) * acked / cwnd;
+
+    double growth = 0;
+    if (w_cubic < _w_est) {
+        growth = (_w_est - cwnd) * mss;
+    } else {
+        //! Approach the target by (target - cwnd) / cwnd segments per segment acknowledged,
+        //! but never more than half a window per RTT.
+        const double target = min(max(w_cubic, cwnd), 1.5 * cwnd);
+        growth = (target - cwnd) / cwnd * acked * mss;
+    }
+
+    _pending_growth += max(growth, 0.0);
+    const auto whole = static_cast<uint64_t>(_pending_growth);
+    _cwnd += whole;
+    _pending_growth -= whole;
+}
+
+//! \details Remembers the window at the loss as W_max (reduced further with fast
+//! convergence, when this loss came before the previous W_max was reached) and
+//! starts a new epoch at the next ACK in congestion avoidance.
+uint64_t Cubic::_reduce(const uint64_t bytes_in_flight) {
+    static_cast<void>(bytes_in_flight);
+    const double cwnd = _cwnd / static_cast<double>(_mss);
+    _w_max = (FAST_CONVERGENCE and cwnd < _w_max) ? cwnd * (1 + BETA) / 2 : cwnd;
+    _epoch_start_ms.reset();
+    _pending_growth = 0;
+    return max(static_cast<uint64_t>(_cwnd * BETA), 2 * _mss);
+}
+
+//! \param[in] mss the sender maximum segment size, in bytes
+Bbr::Bbr(const uint64_t mss)
+    : _mss(mss), _cwnd(NewReno::INITIAL_WINDOW_SEGMENTS * mss), _pacing_gain(HIGH_GAIN), _cwnd_gain(HIGH_GAIN) {}
+
+uint64_t Bbr::_bdp(const double gain) const {
+    return static_cast<uint64_t>(gain * bottleneck_bandwidth() * _min_rtt_ms.value_or(0));
+}
+
+uint64_t Bbr::_target_cwnd() const {
+    if (not _min_rtt_ms.has_value() or _bw_samples.empty()) {
+        return NewReno::INITIAL_WINDOW_SEGMENTS * _mss;
+    }
+    return max(_bdp(_cwnd_gain) + 3 * _mss, MIN_CWND_SEGMENTS * _mss);
+}
+
+uint64_t Bbr::cwnd() const { return _mode == Mode::ProbeRtt ? min(_cwnd, MIN_CWND_SEGMENTS * _mss) : _cwnd; }
+
+//! \details Updates the round count and both filters. The bandwidth filter keeps
+//! the samples of the last BW_WINDOW_ROUNDS round trips that might still become
+//! the maximum. App-limited samples only count when they raise the estimate: an
+//! idle sender measures its own rate, not the network's.
+void Bbr::on_rate_sample(const RateSample &sample) {
+    _delivered = sample.total_delivered;
+    _round_start = sample.prior_delivered >= _next_round_delivered;
+    if (_round_start) {
+        _next_round_delivered = sample.total_delivered;
+        ++_round_count;
+    }
+
+    if (sample.interval_ms > 0) {
+        const double rate = static_cast<double>(sample.delivered) / sample.interval_ms;
+        if (not sample.app_limited or rate >= bottleneck_bandwidth()) {
+            while (not _bw_samples.empty() and _bw_samples.back().second <= rate) {
+                _bw_samples.pop_back();
+            }
+            _bw_samples.emplace_back(_round_count, rate);
+        }
+    }
+    while (_bw_samples.size() > 1 and _bw_samples.front().first + BW_WINDOW_ROUNDS <= _round_count) {
+        _bw_samples.pop_front();
+    }
+
+    _min_rtt_expired = _now_ms > _min_rtt_stamp_ms + MIN_RTT_WINDOW_MS;
+    if (sample.rtt_ms.has_value() and
+        (not _min_rtt_ms.has_value() or sample.rtt_ms.value() <= _min_rtt_ms.value() or _min_rtt_expired)) {
+        _min_rtt_ms = max(sample.rtt_ms.value(), uint64_t{1});
+        _min_rtt_stamp_ms = _now_ms;
+    }
+
+    //! Startup has filled the pipe once three rounds in a row fail to grow the bandwidth by 25%.
+    if (not _filled_pipe and _round_start and not sample.app_limited) {
+        if (bottleneck_bandwidth() >= _full_bw * 1.25) {
+            _full_bw = bottleneck_bandwidth();
+            _full_bw_count = 0;
+        } else if (++_full_bw_count >= 3) {
+            _filled_pipe = true;
+        }
+    }
+}
+
+void Bbr::_enter_probe_bw() {
+    _mode = Mode::ProbeBw;
+    _cwnd_gain = 2;
+    //! Start cruising, two phases before the next probe, rather than with the draining phase.
+    _cycle_index = 2;
+    _cycle_stamp_ms = _now_ms;
+    _pacing_gain = PROBE_BW_GAINS[_cycle_index];
+}
+
+void Bbr::_update_mode(const uint64_t bytes_in_flight) {
+    if (_mode == Mode::Startup and _filled_pipe) {
+        _mode = Mode::Drain;
+        _pacing_gain = 1 / HIGH_GAIN;
+        _cwnd_gain = HIGH_GAIN;
+    }
+    if (_mode == Mode::Drain and bytes_in_flight <= _bdp(1)) {
+        _enter_probe_bw();
+    }
+
+    if (_mode == Mode::ProbeBw) {
+        //! Probe until the extra data is in flight, and drain until the queue is gone, but each for at least an RTT.
+        const bool rtt_elapsed = _now_ms - _cycle_stamp_ms > _min_rtt_ms.value_or(0);
+        const double gain = _pacing_gain;
+        const bool next_phase = gain > 1   ? rtt_elapsed and bytes_in_flight >= _bdp(gain)
+                                : gain < 1 ? rtt_elapsed or bytes_in_flight <= _bdp(1)
+                                           : rtt_elapsed;
+        if (next_phase) {
+            _cycle_index = (_cycle_index + 1) % size(PROBE_BW_GAINS);
+            _cycle_stamp_ms = _now_ms;
+            _pacing_gain = PROBE_BW_GAINS[_cycle_index];
+        }
+    }
+
+    if (_mode != Mode::ProbeRtt and _min_rtt_expired) {
+        _mode = Mode::ProbeRtt;
+        _pacing_gain = 1;
+        _cwnd_gain = 1;
+        _prior_cwnd = max(_prior_cwnd, _cwnd);
+        _probe_rtt_done_ms.reset();
+    }
+
+    if (_mode == Mode::ProbeRtt) {
+        if (not _probe_rtt_done_ms.has_value() and bytes_in_flight <= MIN_CWND_SEGMENTS * _mss) {
+            _probe_rtt_done_ms = _now_ms + PROBE_RTT_MS;
+            _probe_rtt_round_done = false;
+            _next_round_delivered = _delivered;
+        } else if (_probe_rtt_done_ms.has_value()) {
+            _probe_rtt_round_done = _probe_rtt_round_done or _round_start;
+            if (_probe_rtt_round_done and _now_ms >= _probe_rtt_done_ms.value()) {
+                //! Whatever the minimum now is, it was measured just now.
+                _min_rtt_stamp_ms = _now_ms;
+                _min_rtt_expired = false;
+                _cwnd = max(_cwnd, _prior_cwnd);
+                _prior_cwnd = 0;
+                if (_filled_pipe) {
+                    _enter_probe_bw();
+                } else {
+                    _mode = Mode::Startup;
+                    _pacing_gain = HIGH_GAIN;
+                    _cwnd_gain = HIGH_GAIN;
+                }
+            }
+        }
+    }
+}
+
+void Bbr::_update_cwnd(const uint64_t acked_bytes, const uint64_t bytes_in_flight) {
+    if (_conservation) {
+        //! After a timeout, send one segment per segment delivered until a round trip has passed.
+        _cwnd = max(_cwnd, bytes_in_flight + acked_bytes);
+        if (not _round_start) {
+            return;
+        }
+        _conservation = false;
+        _cwnd = max(_cwnd, _prior_cwnd);
+        _prior_cwnd = 0;
+    }
+
+    const uint64_t target = _target_cwnd();
+    if (_filled_pipe) {
+        _cwnd = min(_cwnd + acked_bytes, target);
+    } else if (_cwnd < target or _delivered < NewReno::INITIAL_WINDOW_SEGMENTS * _mss) {
+        _cwnd += acked_bytes;
+    }
+    _cwnd = max(_cwnd, MIN_CWND_SEGMENTS * _mss);
+}
+
+//! \details Until Startup has filled the pipe, the pacing rate only rises: early
+//! samples (the handshake's, or those of a window still growing) underestimate
+//! the bandwidth. It starts from the initial window per min RTT, with high gain.
+void Bbr::_update_pacing_rate() {
+    if (not _min_rtt_ms.has_value()) {
+        return;
+    }
+    if (_pacing_rate == 0) {
+        _pacing_rate = HIGH_GAIN * _cwnd / _min_rtt_ms.value();
+    }
+    const double rate = _pacing_gain * bottleneck_bandwidth();
+    if (_filled_pipe or rate > _pacing_rate) {
+        _pacing_rate = rate;
+    }
+}
+
+bool Bbr::on_ack(const uint64_t ackno, const uint64_t acked_bytes, const uint64_t bytes_in_flight) {
+    static_cast<void>(ackno);
+    _update_mode(bytes_in_flight);
+    _update_pacing_rate();
+    _update_cwnd(acked_bytes, bytes_in_flight);
+    _round_start = false;
+    return false;
+}
+
+bool Bbr::on_duplicate_ack(const uint64_t ackno,
+                           const unsigned dup_acks,
+                           const uint64_t next_seqno,
+                           const uint64_t bytes_in_flight) {
+    static_cast<void>(ackno);
+    static_cast<void>(next_seqno);
+    static_cast<void>(bytes_in_flight);
+    //! Retransmit the hole, but leave the window to the model: a loss says little about the bottleneck.
+    return dup_acks == TCPConfig::DUP_ACK_THRESHOLD;
+}
+
+void Bbr::on_timeout(const uint64_t next_seqno, const uint64_t bytes_in_flight) {
+    static_cast<void>(next_seqno);
+    static_cast<void>(bytes_in_flight);
+    _prior_cwnd = max(_prior_cwnd, _cwnd);
+    _cwnd = _mss;
+    _conservation = true;
+}
+
+//! \param[in] algorithm which controller to create
+//! \param[in] mss the sender maximum segment size, in bytes
+unique_ptr<CongestionController> make_congestion_controller(const TCPConfig::CongestionControl algorithm,
+                                                            const uint64_t mss) {
+    switch (algorithm) {
+        case TCPConfig::CongestionControl::NewReno:
+            return make_unique<NewReno>(mss);
+        case TCPConfig::CongestionControl::Cubic:
+            return make_unique<Cubic>(mss);
+        case TCPConfig::CongestionControl::Bbr:
+            return make_unique<Bbr>(mss);
+        case TCPConfig::CongestionControl::None:
+        default:
+            return nullptr;
+    }
+}
+
+optional<TCPConfig::CongestionControl> congestion_control_from_name(const string &name) {
+    if (name == "none") {
+        return TCPConfig::CongestionControl::None;
+    }
+    if (name == "newreno") {
+        return TCPConfig::CongestionControl::NewReno;
+    }
+    if (name == "cubic") {
+        return TCPConfig::CongestionControl::Cubic;
+    }
+    if (name == "bbr") {
+        return TCPConfig::CongestionControl::Bbr;
+    }
+    return nullopt;
+}
@@ -0,0 +1,315 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
+
+#include "tcp_config.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+//! \brief A delivery-rate sample, taken when an ACK newly acknowledges segments
+
+//! The sender stamps each segment with how much had been delivered, and when,
+//! at the time it was sent. When the segment is acknowledged, the bytes
+//! delivered in between over the time that took give the delivery rate.
+struct RateSample {
+    uint64_t delivered{0};             //!< Bytes delivered over the sampling interval
+    uint64_t interval_ms{0};           //!< Length of the interval: the longer of its send and ACK phases
+    uint64_t prior_delivered{0};       //!< Bytes delivered when the newest acknowledged segment was sent
+    uint64_t total_delivered{0};       //!< Bytes delivered since the connection began
+    std::optional<uint64_t> rtt_ms{};  //!< RTT of the newest acknowledged segment, unless it was retransmitted
+    bool app_limited{false};           //!< Whether the application, not the network, limited the sending rate
+};
+
+//! \brief The congestion-control policy of a TCPSender.
+
+//! The TCPSender reports what it learns from the network (new ACKs,
+//! duplicate ACKs and retransmission timeouts), and the controller answers
+//! with a congestion window. The sender keeps at most min(cwnd, rwnd)
+//! sequence numbers in flight. All quantities are in bytes.
+class CongestionController {
+  public:
+    //! \brief A new ACK acknowledged `acked_bytes` more sequence numbers
+    //! \param ackno the new (absolute) ackno
+    //! \param acked_bytes how many sequence numbers this ACK newly acknowledged
+    //! \param bytes_in_flight how many sequence numbers are still outstanding after the ACK
+    //! \returns `true` if the oldest outstanding segment should be retransmitted right away
+    virtual bool on_ack(const uint64_t ackno, const uint64_t acked_bytes, const uint64_t bytes_in_flight) = 0;
+
+    //! \brief Another ACK repeated the previous ackno while data was outstanding
+    //! \param ackno the repeated (absolute) ackno
+    //! \param dup_acks how many duplicates of `ackno` have arrived in a row, including this one
+    //! \param next_seqno the (absolute) sequence number for the next byte to be sent
+    //! \param bytes_in_flight how many sequence numbers are outstanding
+    //! \returns `true` if the oldest outstanding segment should be retransmitted right away
+    virtual bool on_duplicate_ack(const uint64_t ackno,
+                                  const unsigned dup_acks,
+                                  const uint64_t next_seqno,
+                                  const uint64_t bytes_in_flight) = 0;
+
+    //! \brief The SACK scoreboard deems the oldest outstanding segment lost (RFC 6675)
+    //! \details The sender then retransmits what the scoreboard deems lost while its pipe (an estimate of the
+    //! bytes still in the network) stays under cwnd, so cwnd shouldn't be inflated for each duplicate ACK.
+    //! By default, this is a loss like the one the third duplicate ACK signals.
+    //! \param ackno the (absolute) ackno
+    //! \param next_seqno the (absolute) sequence number for the next byte to be sent
+    //! \param bytes_in_flight how many sequence numbers are outstanding
+    //! \returns `true` if the oldest outstanding segment should be retransmitted right away
+    virtual bool on_sack_loss(const uint64_t ackno, const uint64_t next_seqno, const uint64_t bytes_in_flight) {
+        return on_duplicate_ack(ackno, TCPConfig::DUP_ACK_THRESHOLD, next_seqno, bytes_in_flight);
+    }
+
+    //! \brief The retransmission timer expired
+    //! \param next_seqno the (absolute) sequence number for the next byte to be sent
+    //! \param bytes_in_flight how many sequence numbers are outstanding
+    virtual void on_timeout(const uint64_t next_seqno, const uint64_t bytes_in_flight) = 0;
+
+    //! \brief An ACK produced a delivery-rate sample (reported before on_ack())
+    virtual void on_rate_sample(const RateSample &sample) { static_cast<void>(sample); }
+
+    //! \brief Notifies the controller of the passage of time
+    virtual void tick(const size_t ms_since_last_tick) { static_cast<void>(ms_since_last_tick); }
+
+    //! \returns the rate to pace transmissions at, in bytes per millisecond, or 0 to send as the window allows
+    virtual double pacing_rate() const { return 0; }
+
+    //! \returns the congestion window
+    virtual uint64_t cwnd() const = 0;
+
+    //! \returns the slow-start threshold
+    virtual uint64_t ssthresh() const = 0;
+
+    virtual ~CongestionController() = default;
+};
+
+//! \brief Slow start, congestion avoidance, fast retransmit and NewReno fast recovery (RFC 5681, RFC 6582)
+
+//! Derived controllers keep the slow start and loss recovery, and replace
+//! the window growth in congestion avoidance and the reduction on a loss.
+class NewReno : public CongestionController {
+  private:
+    //! Bytes acknowledged since cwnd last grew in congestion avoidance
+    uint64_t _bytes_acked{0};
+
+    //! Whether we are in fast recovery
+    bool _in_recovery{false};
+
+    //! Whether the SACK scoreboard started it, so the pipe rather than an inflated cwnd limits the sender
+    bool _sack_recovery{false};
+
+    //! Highest sequence number sent when fast recovery started ("recover" in RFC 6582)
+    uint64_t _recover{0};
+
+  protected:
+    //! Sender maximum segment size
+    uint64_t _mss;
+
+    //! Congestion window
+    uint64_t _cwnd;
+
+    //! Slow-start threshold, "arbitrarily high" until the first loss
+    uint64_t _ssthresh{std::numeric_limits<uint64_t>::max()};
+
+    //! Grow cwnd in congestion avoidance: by one segment per window's worth of acknowledged bytes
+    virtual void _congestion_avoidance(const uint64_t acked_bytes);
+
+    //! \brief A loss was detected (by duplicate ACKs or a timeout)
+    //! \returns the new ssthresh: half the flight size, but at least two segments
+    virtual uint64_t _reduce(const uint64_t bytes_in_flight);
+
+  public:
+    //! Initialize with the sender's maximum segment size
+    explicit NewReno(const uint64_t mss);
+
+    bool on_ack(const uint64_t ackno, const uint64_t acked_bytes, const uint64_t bytes_in_flight) override;
+    bool on_duplicate_ack(const uint64_t ackno,
+                          const unsigned dup_acks,
+                          const uint64_t next_seqno,
+                          const uint64_t bytes_in_flight) override;
+    bool on_sack_loss(const uint64_t ackno, const uint64_t next_seqno, const uint64_t bytes_in_flight) override;
+    void on_timeout(const uint64_t next_seqno, const uint64_t bytes_in_flight) override;
+    uint64_t cwnd() const override { return _cwnd; }
+    uint64_t ssthresh() const override { return _ssthresh; }
+
+    //! Initial window, in segments (RFC 6928)
+    static constexpr uint64_t INITIAL_WINDOW_SEGMENTS = 10;
+};
+
+//! \brief CUBIC window growth for fast, long-distance networks (RFC 8312), with NewReno loss recovery
+
+//! After a loss, cwnd follows W(t) = C * (t - K)^3 + W_max: it climbs quickly back
+//! toward the window where the loss happened, plateaus around it, then probes
+//! beyond it. The growth depends on the time since the loss, not on the RTT.
+class Cubic : public NewReno {
+  private:
+    //! Milliseconds elapsed since the controller was created
+    uint64_t _now_ms{0};
+
+    //! When the current congestion avoidance epoch started, if one has
+    std::optional<uint64_t> _epoch_start_ms{};
+
+    //! Window (in segments) just before the last reduction
+    double _w_max{0};
+
+    //! Time (in seconds) W(t) takes to reach W_max again
+    double _k{0};
+
+    //! Estimate of the window (in segments) standard TCP would have now
+    double _w_est{0};
+
+    //! Fractional bytes of window growth not yet added to cwnd
+    double _pending_growth{0};
+
+    //! Latest RTT sample, in milliseconds
+    uint64_t _rtt_ms{0};
+
+    void _congestion_avoidance(const uint64_t acked_bytes) override;
+    uint64_t _reduce(const uint64_t bytes_in_flight) override;
+
+  public:
+    //! Initialize with the sender's maximum segment size
+    explicit Cubic(const uint64_t mss) : NewReno(mss) {}
+
+    void tick(const size_t ms_since_last_tick) override { _now_ms += ms_since_last_tick; }
+    void on_rate_sample(const RateSample &sample) override { _rtt_ms = sample.rtt_ms.value_or(_rtt_ms); }
+
+    static constexpr double C = 0.4;     //!< Scaling constant of the cubic function
+    static constexpr double BETA = 0.7;  //!< Multiplicative decrease factor
+
+    //! Whether a flow that lost before reaching its previous W_max releases bandwidth faster
+    static constexpr bool FAST_CONVERGENCE = true;
+};
+
+//! \brief Model-based congestion control after BBR version 1
+
+//! Rather than reacting to losses, BBR estimates the bottleneck bandwidth
+//! (the windowed maximum of the delivery rate) and the round-trip propagation
+//! delay (the windowed minimum RTT). It paces at a multiple of the bandwidth and
+//! caps the data in flight at a multiple of their product (the BDP), so a queue
+//! only builds briefly while it probes for more bandwidth.
+class Bbr : public CongestionController {
+  public:
+    //! The phases of the BBR state machine
+    enum class Mode {
+        Startup,  //!< Double the sending rate every round trip until the bandwidth stops growing
+        Drain,    //!< Drain the queue that Startup built
+        ProbeBw,  //!< Cycle the pacing gain around 1 to probe for more bandwidth
+        ProbeRtt  //!< Shrink the flight to a few segments to measure the propagation delay
+    };
+
+  private:
+    //! Sender maximum segment size
+    uint64_t _mss;
+
+    //! Milliseconds elapsed since the controller was created
+    uint64_t _now_ms{0};
+
+    //! Current phase
+    Mode _mode{Mode::Startup};
+
+    //! Congestion window
+    uint64_t _cwnd;
+
+    //! Window saved on entering ProbeRtt or after a timeout, restored afterwards
+    uint64_t _prior_cwnd{0};
+
+    //! Gains applied to the bandwidth for the pacing rate and to the BDP for cwnd
+    double _pacing_gain;
+    double _cwnd_gain;
+
+    //! Pacing rate, in bytes per ms (0 until the first RTT sample)
+    double _pacing_rate{0};
+
+    //! Delivery-rate samples (round, bytes per ms) in the bandwidth window, with decreasing rates
+    std::deque<std::pair<uint64_t, double>> _bw_samples{};
+
+    //! Minimum RTT seen in the last MIN_RTT_WINDOW_MS, and when it was seen
+    std::optional<uint64_t> _min_rtt_ms{};
+    uint64_t _min_rtt_stamp_ms{0};
+    bool _min_rtt_expired{false};
+
+    //! Round trips counted so far: a round ends when a segment sent after it began is acknowledged
+    uint64_t _round_count{0};
+    uint64_t _next_round_delivered{0};
+    bool _round_start{false};
+    uint64_t _delivered{0};
+
+    //! Whether Startup has found the bandwidth, and the last bandwidth that grew by enough
+    bool _filled_pipe{false};
+    double _full_bw{0};
+    unsigned _full_bw_count{0};
+
+    //! Position in the ProbeBw gain cycle and when it began
+    unsigned _cycle_index{0};
+    uint64_t _cycle_stamp_ms{0};
+
+    //! When ProbeRtt may end, once the flight has drained, and whether a round has passed since
+    std::optional<uint64_t> _probe_rtt_done_ms{};
+    bool _probe_rtt_round_done{false};
+
+    //! Whether a timeout happened and cwnd follows packet conservation until the next round
+    bool _conservation{false};
+
+    //! \returns `gain` times the estimated bandwidth-delay product, in bytes
+    uint64_t _bdp(const double gain) const;
+
+    //! \returns the window to grow toward: the BDP with cwnd gain, plus room for delayed and stretched ACKs
+    uint64_t _target_cwnd() const;
+
+    void _enter_probe_bw();
+    void _update_mode(const uint64_t bytes_in_flight);
+    void _update_cwnd(const uint64_t acked_bytes, const uint64_t bytes_in_flight);
+    void _update_pacing_rate();
+
+  public:
+    //! Initialize with the sender's maximum segment size
+    explicit Bbr(const uint64_t mss);
+
+    void on_rate_sample(const RateSample &sample) override;
+    bool on_ack(const uint64_t ackno, const uint64_t acked_bytes, const uint64_t bytes_in_flight) override;
+    bool on_duplicate_ack(const uint64_t ackno,
+                          const unsigned dup_acks,
+                          const uint64_t next_seqno,
+                          const uint64_t bytes_in_flight) override;
+    void on_timeout(const uint64_t next_seqno, const uint64_t bytes_in_flight) override;
+    void tick(const size_t ms_since_last_tick) override { _now_ms += ms_since_last_tick; }
+    double pacing_rate() const override { return _pacing_rate; }
+    uint64_t cwnd() const override;
+
+    //! BBR has no slow-start threshold
+    uint64_t ssthresh() const override { return std::numeric_limits<uint64_t>::max(); }
+
+    //! Current phase
+    Mode mode() const { return _mode; }
+
+    //! \returns the estimated bottleneck bandwidth, in bytes per millisecond (0 before the first sample)
+    double bottleneck_bandwidth() const { return _bw_samples.empty() ? 0 : _bw_samples.front().second; }
+
+    //! \returns the estimated round-trip propagation delay, in milliseconds, if measured
+    std::optional<uint64_t> min_rtt() const { return _min_rtt_ms; }
+
+    static constexpr double HIGH_GAIN = 2.885;             //!< 2/ln(2): doubles the sending rate each round
+    static constexpr unsigned BW_WINDOW_ROUNDS = 10;       //!< Length of the bandwidth filter, in round trips
+    static constexpr uint64_t MIN_RTT_WINDOW_MS = 10'000;  //!< Length of the min-RTT filter
+    static constexpr uint64_t PROBE_RTT_MS = 200;          //!< Time to hold the flight down in ProbeRtt
+    static constexpr uint64_t MIN_CWND_SEGMENTS = 4;       //!< Smallest window, and the window in ProbeRtt
+
+    //! Pacing gains of the ProbeBw cycle, one phase per min RTT
+    static constexpr double PROBE_BW_GAINS[] = {1.25, 0.75, 1, 1, 1, 1, 1, 1};
+};
+
+//! \brief Create the congestion controller selected in a TCPConfig
+//! \returns nullptr for TCPConfig::CongestionControl::None
+std::unique_ptr<CongestionController> make_congestion_controller(const TCPConfig::CongestionControl algorithm,
+                                                                 const uint64_t mss);
+
+//! \brief Look up a congestion control algorithm by name ("none", "newreno", "cubic" or "bbr")
+//! \returns empty if the name is unknown
+std::optional<TCPConfig::CongestionControl> congestion_control_from_name(const std::string &name);
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
@@ -3,6 +3,7 @@
 #include "arp_message.hh"
 #include "ethernet_frame.hh"
 
+#include <algorithm>
 #include <iostream>
 
 // Dummy implementation of a network interface
@@ -40,7 +41,7 @@ void NetworkInterface::send_datagram(const InternetDatagram &dgram, const Addres
     // If the destination Ethernet address is already known, send it right away.
     if (iter != _arp_table.end()) {
         frame.header() = {
-            iter->second.eth_address,
+            iter->second,
             _ethernet_address,
             EthernetHeader::TYPE_IPv4,
         };
@@ -52,7 +53,7 @@ void NetworkInterface::send_datagram(const InternetDatagram &dgram, const Addres
     // If the destination Ethernet address is unknown,
     // broadcast an ARP request for the next hop’s Ethernet address,
     // and queue the IP datagram, so it can be sent after the ARP reply is received.
-    if (_waiting_arp_request_map.find(next_hop_ip) == _waiting_arp_request_map.end()) {
+    if (not _arp_request_retry.armed(next_hop_ip)) {
         ARPMessage arp_message;
         arp_message.opcode = ARPMessage::OPCODE_REQUEST;
         arp_message.sender_ethernet_address = _ethernet_address;
@@ -67,7 +68,7 @@ void NetworkInterface::send_datagram(const InternetDatagram &dgram, const Addres
         frame.payload() = arp_message.serialize();
         _frames_out.emplace(frame);
 
-        _waiting_arp_request_map[next_hop_ip] = ARP_REQUEST_DEFAULT_TTL;
+        _arp_request_retry.arm(next_hop_ip, ARP_REQUEST_DEFAULT_TTL);
     }
     _waiting_datagrams.emplace_back(next_hop, dgram);
 }
@@ -119,7 +120,8 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
         }
 
         if (is_arp_request || is_arp_response) {
-            _arp_table[src_ip_address] = {src_eth_address, ARP_ENTRY_DEFAULT_TTL};
+            _arp_table[src_ip_address] = src_eth_address;
+            _arp_entry_expiry.arm(src_ip_address, ARP_ENTRY_DEFAULT_TTL);
             for (auto iter = _waiting_datagrams.begin(); iter != _waiting_datagrams.end();) {
                 if (iter->first.ipv4_numeric() == src_ip_address) {
                     send_datagram(iter->second, iter->first);
@@ -127,7 +129,7 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
                 } else
                     ++iter;
             }
-            _waiting_arp_request_map.erase(src_ip_address);
+            _arp_request_retry.cancel(src_ip_address);
         }
     }
     return nullopt;
@@ -135,34 +137,33 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void NetworkInterface::tick(const size_t ms_since_last_tick) {
-    for (auto iter = _arp_table.begin(); iter != _arp_table.end(); /* nop */) {
-        if (iter->second.ttl <= ms_since_last_tick)
-            iter = _arp_table.erase(iter);
-        else {
-            iter->second.ttl -= ms_since_last_tick;
-            ++iter;
-        }
+    for (const auto ip : _arp_entry_expiry.advance(ms_since_last_tick)) {
+        _arp_table.erase(ip);
     }
-    for (auto iter = _waiting_arp_request_map.begin(); iter != _waiting_arp_request_map.end(); /* nop */) {
-        if (iter->second <= ms_since_last_tick) {
-            ARPMessage arp_message;
-            arp_message.opcode = ARPMessage::OPCODE_REQUEST;
-            arp_message.sender_ethernet_address = _ethernet_address;
-            arp_message.sender_ip_address = _ip_address.ipv4_numeric();
-            arp_message.target_ethernet_address = {};
-            arp_message.target_ip_address = iter->first;
-
-            EthernetFrame eth_frame;
-            eth_frame.header() = {/* dst  */ ETHERNET_BROADCAST,
-                                  /* src  */ _ethernet_address,
-                                  /* type */ EthernetHeader::TYPE_ARP};
-            eth_frame.payload() = arp_message.serialize();
-            _frames_out.push(eth_frame);
-
-            iter->second = ARP_REQUEST_DEFAULT_TTL;
-        } else {
-            iter->second -= ms_since_last_tick;
-            ++iter;
-        }
+    for (const auto ip : _arp_request_retry.advance(ms_since_last_tick)) {
+        ARPMessage arp_message;
+        arp_message.opcode = ARPMessage::OPCODE_REQUEST;
+        arp_message.sender_ethernet_address = _ethernet_address;
+        arp_message.sender_ip_address = _ip_address.ipv4_numeric();
+        arp_message.target_ethernet_address = {};
+        arp_message.target_ip_address = ip;
+
+        EthernetFrame eth_frame;
+        eth_frame.header() = {/* dst  */ ETHERNET_BROADCAST,
+                              /* src  */ _ethernet_address,
+                              /* type */ EthernetHeader::TYPE_ARP};
+        eth_frame.payload() = arp_message.serialize();
+        _frames_out.push(eth_frame);
+
+        _arp_request_retry.arm(ip, ARP_REQUEST_DEFAULT_TTL);
+    }
+}
+
+optional<size_t> NetworkInterface::time_until_next_timer() const {
+    const auto entry = _arp_entry_expiry.time_until_next();
+    const auto request = _arp_request_retry.time_until_next();
+    if (entry.has_value() and request.has_value()) {
+        return min(entry.value(), request.value());
     }
+    return entry.has_value() ? entry : request;
 }
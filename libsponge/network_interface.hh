@@ -3,6 +3,7 @@
 
 #include "ethernet_frame.hh"
 #include "tcp_over_ip.hh"
+#include "timer_wheel.hh"
 #include "tun.hh"
 
 #include <list>
@@ -36,18 +37,14 @@ class NetworkInterface {
     static constexpr size_t ARP_ENTRY_DEFAULT_TTL = 30 * 1000;
     static constexpr size_t ARP_REQUEST_DEFAULT_TTL = 5 * 1000;
 
-    //! ARP entry in ARP table.
-    //! It includes Ethernet address and TTL.
-    struct ARPEntry {
-        EthernetAddress eth_address;
-        size_t ttl;
-    };
-
     //! The ARP table of the interface.
-    std::unordered_map<uint32_t, ARPEntry> _arp_table{};
+    std::unordered_map<uint32_t, EthernetAddress> _arp_table{};
+
+    //! When each entry of the ARP table expires, keyed by IP address.
+    TimerWheel _arp_entry_expiry{};
 
-    //! The arp response that waiting reply.
-    std::unordered_map<uint32_t, size_t> _waiting_arp_request_map{};
+    //! When each ARP request still waiting for a reply is sent again, keyed by IP address.
+    TimerWheel _arp_request_retry{};
 
     //! The datagrams that waiting to send.
     std::list<std::pair<Address, InternetDatagram>> _waiting_datagrams{};
@@ -83,6 +80,9 @@ class NetworkInterface {
 
     //! \brief Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief Milliseconds until an ARP entry expires or a request is sent again, or empty if neither is pending
+    std::optional<size_t> time_until_next_timer() const;
 };
 
 #endif  // SPONGE_LIBSPONGE_NETWORK_INTERFACE_HH
@@ -12,95 +12,220 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity)
-    : _output(capacity), _capacity(capacity), _first_unacceptable(capacity) {}
+//! \returns the bits in a presence bitmap for `capacity` bytes: a power of two (of at least
+//! one word) so that stream indices map onto bits with a mask
+static size_t bitmap_bits_for(const size_t capacity) {
+    size_t bits = 64;
+    while (bits < capacity) {
+        bits <<= 1;
+    }
+    return bits;
+}
+
+//! \param[in] capacity the maximum number of bytes, reassembled or not, held at once
+//! \param[in] storage how to keep bytes that can't be reassembled yet
+StreamReassembler::StreamReassembler(const size_t capacity, const Storage storage)
+    : _storage(storage), _output(capacity), _capacity(capacity), _first_unacceptable(capacity) {
+    if (_storage == Storage::Ring) {
+        const size_t bits = bitmap_bits_for(capacity);
+        _present.resize(bits / 64);
+        _present_mask = bits - 1;
+    }
+}
+
+//! \param[in] capacity the new maximum number of bytes, reassembled or not, held at once
+//! \details With ring storage, a bitmap of a different size is rebuilt from the stored ranges.
+void StreamReassembler::set_capacity(const size_t capacity) {
+    const auto ranges = unassembled_ranges();
+    _first_unread = _output.bytes_read();
+    const size_t held = ranges.empty() ? _output.buffer_size() : ranges.back().second - _first_unread;
+    _capacity = max(capacity, held);
+    _output.set_capacity(_capacity);
+    _first_unacceptable = _first_unread + _capacity;
+
+    const size_t bits = bitmap_bits_for(_capacity);
+    if (_storage == Storage::Ring && bits - 1 != _present_mask) {
+        _present.assign(bits / 64, 0);
+        _present_mask = bits - 1;
+        for (const auto &[begin, end] : ranges) {
+            _mark_present(begin, end);
+        }
+    }
+}
 
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
 void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    _first_unread = _output.bytes_read();
-    _first_unacceptable = _first_unread + _capacity;
-    segment s = {index, data};
-    _add_segment(s, eof);
-    _stitch_output();
-    if (empty() && _eof) {
-        _output.end_input();
-    }
+    _push_substring(data, index, eof);
 }
 
-size_t StreamReassembler::unassembled_bytes() const {
-    size_t unassembled_bytes = 0;
-    for (const auto &_segment : _segments) {
-        unassembled_bytes += _segment.data.size();
-    }
-    return unassembled_bytes;
+void StreamReassembler::push_substring(const Buffer &data, const size_t index, const bool eof) {
+    _push_substring(data.str(), index, eof);
 }
 
-bool StreamReassembler::empty() const { return unassembled_bytes() == 0; }
+void StreamReassembler::_push_substring(const string_view data, const size_t index, const bool eof) {
+    _first_unread = _output.bytes_read();
+    _first_unacceptable = _first_unread + _capacity;
 
-void StreamReassembler::_add_segment(StreamReassembler::segment &s, const bool eof) {
     //!< If the segment is out of assemble range, ignore it.
-    if (s.index >= _first_unacceptable || s.index + s.data.size() < _first_unassembled) {
+    if (index >= _first_unacceptable || index + data.size() < _first_unassembled) {
         return;
     }
 
-    bool seg_eof = eof;
-    //!< If the segment is overflow, cut the bytes until the last acceptable index.
-    if (s.index + s.data.size() > _first_unacceptable) {
-        s.data = s.data.substr(0, _first_unacceptable - s.index);
-        seg_eof = false;
+    //!< An overflowing segment is cut at the last acceptable index, so its EOF doesn't count.
+    // if EOF was received before, it should remain valid
+    _eof = _eof || (eof && index + data.size() <= _first_unacceptable);
+
+    if (index == _first_unassembled && empty()) {
+        //!< Fast path: in-order data with nothing buffered goes straight into the output.
+        const size_t length = _output.stage(0, data);
+        _output.commit(length);
+        _first_unassembled += length;
+    } else if (_storage == Storage::Ring) {
+        _add_to_ring(data, index);
+        _stitch_ring();
+    } else {
+        _add_segment(data, index);
+        _stitch_output();
+    }
+    if (empty() && _eof) {
+        _output.end_input();
     }
+}
 
-    //!< If the segment has parts unassembled, cut the bytes start from first unassembled index.
-    if (s.index < _first_unassembled) {
-        s.data = s.data.substr(_first_unassembled - s.index);
-        s.index = _first_unassembled;
+//! \details Existing segments win over new data: the new bytes are trimmed to the gap
+//! between the stored segment ending before them and the first one that they don't
+//! completely cover. Stored segments that they do cover are dropped, so each push costs
+//! O(log n) plus the number of segments it swallows.
+void StreamReassembler::_add_segment(const string_view data, const size_t index) {
+    size_t begin = max(index, _first_unassembled);
+    size_t end = min(index + data.size(), _first_unacceptable);
+
+    //!< Trim the front against the segment starting at or before `begin`.
+    auto it = _segments.upper_bound(begin);
+    if (it != _segments.begin()) {
+        const auto prev = std::prev(it);
+        begin = max(begin, prev->first + prev->second.size());
     }
 
-    for (auto it = _segments.begin(); it != _segments.end();) {
-        if (_is_overlapping(s, *it)) {
-            _merge_segments(s, *it);
-            _segments.erase(it++);
-        } else {
-            it++;
+    //!< Drop the segments covered by [begin, end), and trim the back against a partial one.
+    while (it != _segments.end() && it->first < end) {
+        if (it->first + it->second.size() > end) {
+            end = it->first;
+            break;
         }
+        _unassembled_bytes -= it->second.size();
+        it = _segments.erase(it);
     }
-    _segments.insert(s);
 
-    // if EOF was received before, it should remain valid
-    _eof = _eof || seg_eof;
+    if (begin >= end) {
+        return;
+    }
+    _segments.emplace_hint(it, begin, string(data.substr(begin - index, end - begin)));
+    _unassembled_bytes += end - begin;
 }
 
-void StreamReassembler::_merge_segments(StreamReassembler::segment &s, const StreamReassembler::segment &other) {
-    segment left{}, right{};
-    if (s.index < other.index) {
-        left = s;
-        right = other;
-    } else {
-        right = s;
-        left = other;
+void StreamReassembler::_stitch_output() {
+    while (!_segments.empty() && _segments.begin()->first == _first_unassembled) {
+        const string &data = _segments.begin()->second;
+        _output.write(data);
+        // Same as `_first_unassembled = _output.bytes_written();`
+        _first_unassembled += data.size();
+        _unassembled_bytes -= data.size();
+        _segments.erase(_segments.begin());
     }
+}
 
-    if (left.index + left.data.size() >= right.index + right.data.size()) {
-        s = left;
-    } else {
-        s.index = left.index;
-        s.data = left.data + right.data.substr(left.index + left.data.size() - right.index);
+//! \details The bytes go straight to their final place in the output stream's storage (past
+//! its input side, where they stay invisible to the reader), so stitching them later is just
+//! ByteStream::commit(). Marking the bitmap a word at a time also counts the newly present bytes.
+void StreamReassembler::_add_to_ring(const string_view data, const size_t index) {
+    size_t begin = max(index, _first_unassembled);
+    const size_t end = min(index + data.size(), _first_unacceptable);
+    if (begin >= end) {
+        return;
     }
+    _output.stage(begin - _first_unassembled, data.substr(begin - index, end - begin));
+    _unassembled_bytes += _mark_present(begin, end);
 }
 
-bool StreamReassembler::_is_overlapping(const StreamReassembler::segment &a, const StreamReassembler::segment &b) {
-    return max(a.index, b.index) < min(a.index + a.data.size(), b.index + b.data.size());
+size_t StreamReassembler::_mark_present(size_t begin, const size_t end) {
+    size_t added = 0;
+    while (begin < end) {
+        const size_t bit = begin & _present_mask;
+        const size_t n = min(64 - bit % 64, end - begin);
+        const uint64_t mask = (n == 64 ? ~uint64_t{0} : ((uint64_t{1} << n) - 1)) << (bit % 64);
+        uint64_t &word = _present[bit / 64];
+        added += __builtin_popcountll(mask & ~word);
+        word |= mask;
+        begin += n;
+    }
+    return added;
 }
-void StreamReassembler::_stitch_output() {
-    while (!_segments.empty() && _segments.begin()->index == _first_unassembled) {
-        _stitch_segment(*_segments.begin());
-        _segments.erase(_segments.begin());
+
+//! \details Scans the bitmap a word at a time, counting trailing ones to find the next hole.
+void StreamReassembler::_stitch_ring() {
+    size_t length = 0;
+    while (true) {
+        const size_t bit = (_first_unassembled + length) & _present_mask;
+        uint64_t &word = _present[bit / 64];
+        const uint64_t run_bits = ~(word >> (bit % 64));
+        const size_t run = run_bits == 0 ? 64 : __builtin_ctzll(run_bits);
+        if (run == 0) {
+            break;
+        }
+        const uint64_t mask = (run == 64 ? ~uint64_t{0} : ((uint64_t{1} << run) - 1)) << (bit % 64);
+        word &= ~mask;
+        length += run;
+        if (bit % 64 + run < 64) {
+            break;
+        }
     }
+    _output.commit(length);
+    _first_unassembled += length;
+    _unassembled_bytes -= length;
 }
-void StreamReassembler::_stitch_segment(const StreamReassembler::segment &s) {
-    _output.write(s.data);
-    // Same as `_first_unassembled = _output.bytes_written();`
-    _first_unassembled += s.data.size();
+
+//! \details Ring storage scans the bitmap a word at a time, skipping holes and runs with ctz.
+vector<pair<size_t, size_t>> StreamReassembler::unassembled_ranges() const {
+    vector<pair<size_t, size_t>> ranges;
+    const auto add = [&ranges](const size_t begin, const size_t end) {
+        if (!ranges.empty() && ranges.back().second == begin) {
+            ranges.back().second = end;
+        } else {
+            ranges.emplace_back(begin, end);
+        }
+    };
+    if (empty()) {
+        return ranges;
+    }
+
+    if (_storage == Storage::Segments) {
+        for (const auto &[index, data] : _segments) {
+            add(index, index + data.size());
+        }
+        return ranges;
+    }
+
+    for (size_t i = _first_unassembled; i < _first_unacceptable;) {
+        const size_t bit = i & _present_mask;
+        const size_t n = min(64 - bit % 64, _first_unacceptable - i);
+        uint64_t word = _present[bit / 64] >> (bit % 64);
+        if (n < 64) {
+            word &= (uint64_t{1} << n) - 1;
+        }
+        size_t offset = 0;
+        while (word != 0) {
+            const size_t holes = __builtin_ctzll(word);
+            word >>= holes;
+            offset += holes;
+            const size_t run = ~word == 0 ? 64 : __builtin_ctzll(~word);
+            add(i + offset, i + offset + run);
+            offset += run;
+            word = run == 64 ? 0 : word >> run;
+        }
+        i += n;
+    }
+    return ranges;
 }
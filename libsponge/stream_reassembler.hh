@@ -4,49 +4,73 @@
 #include "byte_stream.hh"
 
 #include <cstdint>
-#include <set>
+#include <map>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
-  private:
-    // Your code here -- add private members as necessary.
-    //! Segment is the substring of byte stream.
-    struct segment {
-        size_t index;  //!< The begin index of the segment
-        string data;   //!< The data of the segment
-        bool operator<(const segment &s) const { return index < s.index; }
+  public:
+    //! \brief Where unassembled bytes are kept until they can be stitched
+    enum class Storage {
+        Segments,  //!< An ordered map of non-overlapping segments, each in its own string
+        Ring       //!< In place in the output stream's ring, with a presence bitmap
     };
 
-    ByteStream _output;                //!< The reassembled in-order byte stream
-    size_t _capacity;                  //!< The maximum number of bytes
-    bool _eof = false;                 //!< Whether the last byte of `data` will be the last byte in the entire stream
-    size_t _first_unread = 0;          //!< The first unread bytes index
-    size_t _first_unassembled = 0;     //!< The first unassembled bytes index
-    size_t _first_unacceptable;        //!< The first unacceptable bytes index
-    std::set<segment> _segments = {};  //!< The stored segments
-
-    //! Add segment to the StreamReassembler
-    void _add_segment(segment &s, const bool eof);
-
-    //! Merge two segments.
-    static void _merge_segments(segment &s, const segment &other);
-
-    //! Whether two segments overlapping.
-    static bool _is_overlapping(const segment &a, const segment &b);
+  private:
+    // Your code here -- add private members as necessary.
+    Storage _storage;               //!< How unassembled bytes are stored
+    ByteStream _output;             //!< The reassembled in-order byte stream
+    size_t _capacity;               //!< The maximum number of bytes
+    bool _eof = false;              //!< Whether the last byte of `data` will be the last byte in the entire stream
+    size_t _first_unread = 0;       //!< The first unread bytes index
+    size_t _first_unassembled = 0;  //!< The first unassembled bytes index
+    size_t _first_unacceptable;     //!< The first unacceptable bytes index
+    size_t _unassembled_bytes = 0;  //!< The number of bytes stored in `_segments`
+
+    //! The stored segments, keyed by the index of their first byte.
+    //! Segments never overlap each other, so the map is also ordered by end index.
+    std::map<size_t, std::string> _segments = {};
+
+    //! Ring storage: one bit per byte past the output's input side, set if the byte has been staged.
+    //! Bit `i & _present_mask` stands for stream index `i`.
+    std::vector<uint64_t> _present = {};
+    size_t _present_mask = 0;  //!< Number of bits in `_present` minus one
+
+    //! Reassemble `data`, whichever type it arrived as (see push_substring()).
+    void _push_substring(const std::string_view data, const uint64_t index, const bool eof);
+
+    //! Store the acceptable part of `data` that isn't already stored.
+    void _add_segment(const std::string_view data, const size_t index);
 
     //! Stitch output until the first unassembled index.
     void _stitch_output();
 
-    //! Write data string of segment into output.
-    void _stitch_segment(const segment &s);
+    //! Ring storage: stage the acceptable part of `data` in the output stream and mark it present.
+    void _add_to_ring(const std::string_view data, const size_t index);
+
+    //! Ring storage: commit the run of present bytes at the first unassembled index.
+    void _stitch_ring();
+
+    //! Ring storage: mark the bytes in [begin, end) present.
+    //! \returns how many of them were not already
+    size_t _mark_present(size_t begin, const size_t end);
 
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    StreamReassembler(const size_t capacity, const Storage storage = Storage::Segments);
+
+    //! \brief The most bytes held at once, reassembled or not
+    size_t capacity() const { return _capacity; }
+
+    //! \brief Grow or shrink the capacity (and the output stream's with it)
+    //! \note It never shrinks below what is held: the unread output and every stored byte stay acceptable.
+    void set_capacity(const size_t capacity);
 
     //! \brief Receive a substring and write any newly contiguous bytes into the stream.
     //!
@@ -58,6 +82,10 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring held in a shared Buffer (e.g. a TCPSegment payload)
+    //! \details Same as above, but the bytes are copied straight from the Buffer's storage.
+    void push_substring(const Buffer &data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -68,13 +96,17 @@ class StreamReassembler {
     //!
     //! \note If the byte at a particular index has been pushed more than once, it
     //! should only be counted once for the purpose of this function.
-    size_t unassembled_bytes() const;
+    size_t unassembled_bytes() const { return _unassembled_bytes; }
 
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
-    bool empty() const;
+    bool empty() const { return _unassembled_bytes == 0; }
 
     size_t first_unassembled() const { return _first_unassembled; }
+
+    //! \brief The stored-but-unassembled bytes, as ascending [begin, end) index ranges
+    //! \details Adjacent ranges are merged, so every pair is separated by a hole.
+    std::vector<std::pair<size_t, size_t>> unassembled_ranges() const;
 };
 
 #endif  // SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
@@ -1,6 +1,8 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 // Dummy implementation of a TCP connection
 
@@ -20,6 +22,14 @@ size_t TCPConnection::unassembled_bytes() const { return _receiver.unassembled_b
 
 size_t TCPConnection::time_since_last_segment_received() const { return _time_since_last_segment_received; }
 
+uint8_t TCPConnection::_window_scale_for(const size_t capacity) {
+    uint8_t shift = 0;
+    while (shift < TCPHeader::MAX_WINDOW_SCALE && (capacity >> shift) > numeric_limits<uint16_t>::max()) {
+        ++shift;
+    }
+    return shift;
+}
+
 void TCPConnection::segment_received(const TCPSegment &seg) {
     if (!_active) {
         return;
@@ -29,6 +39,17 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     _time_since_last_segment_received = 0;
 
     const TCPHeader &header = seg.header();
+    // Options only count on the SYN that opens the connection (RFC 7323, 2.2); a later SYN changes nothing.
+    if (header.syn && !_receiver.ackno().has_value()) {
+        _peer_window_scale = header.window_scale;
+        _peer_timestamps = header.timestamp.has_value();
+        _peer_sack_permitted = header.sack_permitted;
+        // Without the option, keep sending at our own MSS; an MSS of zero would stall the sender.
+        if (header.mss.value_or(0) > 0) {
+            _peer_mss = min(_cfg.mss, size_t{header.mss.value()});
+            _sender.set_mss(_peer_mss);
+        }
+    }
 
     // If sender is `CLOSED` and receiver is `LISTEN`, the connection's state is `LISTEN`.
     // As the receiver side, it should only accept `SYN` segment.
@@ -70,15 +91,41 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         }
     }
 
+    // PAWS: a segment with an old timestamp is a duplicate from long ago (perhaps from a previous
+    // wrap of the sequence space). Drop it, but acknowledge it if it occupied sequence numbers.
+    if (_stale_timestamp(seg)) {
+        if (seg.length_in_sequence_space() > 0) {
+            _sender.send_empty_segment();
+        }
+        send_segments();
+        return;
+    }
+
+    const optional<WrappingInt32> ackno_before = _receiver.ackno();
+    const bool held_out_of_order = _receiver.unassembled_bytes() > 0;
     _receiver.segment_received(seg);
-    _sender.ack_received(header.ackno, header.win);
+    _sample_receiver_rtt();
+    // The window in a SYN is never scaled.
+    const uint64_t peer_window =
+        header.syn || !_window_scaling() ? header.win : uint64_t{header.win} << _peer_window_scale.value();
+    const optional<uint32_t> timestamp_echo =
+        _timestamps() && header.timestamp.has_value() ? optional<uint32_t>{header.timestamp->echo} : nullopt;
+    _sender.ack_received(
+        header.ackno, peer_window, seg.length_in_sequence_space() == 0, header.sack_blocks, timestamp_echo);
+    _autotune_send_buffer();
 
     // If the incoming segment occupied any sequence numbers, the TCPConnection makes
     // sure that at least one segment is sent in reply, to reflect an update in the ackno and
     // window size.
+    // With delayed ACKs, the reply to in-order data may wait for more data or for the delay to pass.
     _sender.fill_window();
     if (_sender.segments_out().empty() && seg.length_in_sequence_space() > 0) {
-        _sender.send_empty_segment();
+        const bool in_order = ackno_before.has_value() && !held_out_of_order && _receiver.unassembled_bytes() == 0 &&
+                              _receiver.ackno().value() - ackno_before.value() ==
+                                  static_cast<int32_t>(seg.length_in_sequence_space());
+        if (!_delay_ack(seg, in_order)) {
+            _sender.send_empty_segment();
+        }
     }
 
     // If the segment's `RST` flag is set, sets both the inbound and outbound streams to the error
@@ -99,6 +146,15 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     send_segments();
 }
 
+bool TCPConnection::_stale_timestamp(const TCPSegment &seg) const {
+    const TCPHeader &header = seg.header();
+    const auto recent = _receiver.timestamp_recent();
+    if (!_timestamps() || header.rst || !header.timestamp.has_value() || !recent.has_value()) {
+        return false;
+    }
+    return static_cast<int32_t>(header.timestamp->value - recent.value()) < 0;
+}
+
 bool TCPConnection::active() const { return _active; }
 
 size_t TCPConnection::write(const string &data) {
@@ -122,6 +178,10 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
 
     _time_since_last_segment_received += ms_since_last_tick;
     _sender.tick(ms_since_last_tick);
+    _tick_delayed_ack(ms_since_last_tick);
+    _autotune_receive_buffer();
+    _balance_memory();
+    _send_window_update();
     // if the number of consecutive retransmissions is more than an upper limit,
     // abort the connection, and send a reset segment to the peer.
     if (_sender.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS) {
@@ -135,12 +195,37 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
     send_segments();
 }
 
+optional<size_t> TCPConnection::time_until_next_timer() const {
+    if (!_active) {
+        return nullopt;
+    }
+    optional<size_t> next = _sender.time_until_next_timer();
+    const auto consider = [&next](const size_t ms) { next = min(next.value_or(ms), ms); };
+
+    if (_ack_delay_elapsed.has_value()) {
+        consider(_cfg.delayed_ack_ms - min<size_t>(_ack_delay_elapsed.value(), _cfg.delayed_ack_ms));
+    }
+    if (_receiver.stream_out().input_ended() && _sender.stream_in().eof() && _sender.bytes_in_flight() == 0) {
+        const size_t linger = _linger_after_streams_finish ? 10 * _cfg.rt_timeout : 0;
+        consider(linger - min(_time_since_last_segment_received, linger));
+    }
+    if (_idle_shrink_pending()) {
+        consider(TCPConfig::RECV_IDLE_MS - min<size_t>(_time_since_last_segment_received, TCPConfig::RECV_IDLE_MS));
+    }
+    return next;
+}
+
 void TCPConnection::end_input_stream() {
     _sender.stream_in().end_input();
     _sender.fill_window();
     send_segments();
 }
 
+void TCPConnection::set_corked(const bool corked) {
+    _sender.set_corked(corked);
+    send_segments();
+}
+
 void TCPConnection::connect() {
     _sender.fill_window();
     send_segments();
@@ -160,7 +245,7 @@ TCPConnection::~TCPConnection() {
 }
 void TCPConnection::send_segments() {
     while (!_sender.segments_out().empty()) {
-        TCPSegment seg = _sender.segments_out().front();
+        TCPSegment seg = move(_sender.segments_out().front());
         _sender.segments_out().pop();
         // Before sending the segment, the TCPConnection will ask the TCPReceiver for the fields
         // it’s responsible for on outgoing segments: ackno and window size. If there is an ackno,
@@ -169,13 +254,191 @@ void TCPConnection::send_segments() {
             seg.header().ack = true;
             seg.header().ackno = _receiver.ackno().value();
         }
-        // "Send the biggest value you can. You might find the std::numeric limits class helpful."
-        seg.header().win = min(_receiver.window_size(), numeric_limits<size_t>::max());
-        _segments_out.emplace(seg);
+        // Our SYN always carries our MSS. The other options are offered on our SYN (or, answering a SYN, only
+        // if the peer offered them), and used once both sides agreed.
+        if (seg.header().syn) {
+            seg.header().mss = min(_cfg.mss, size_t{numeric_limits<uint16_t>::max()});
+            seg.header().sack_permitted = _cfg.sack && (!_receiver.ackno().has_value() || _peer_sack_permitted);
+            if (_cfg.window_scaling && (!_receiver.ackno().has_value() || _peer_window_scale.has_value())) {
+                seg.header().window_scale = _window_scale;
+            }
+        }
+        if ((seg.header().syn && _cfg.timestamps && (!_receiver.ackno().has_value() || _peer_timestamps)) ||
+            _timestamps()) {
+            seg.header().timestamp = {_sender.timestamp(), _receiver.timestamp_recent().value_or(0)};
+        }
+        // "Send the biggest value you can", in units of the window scale; a SYN's window is never scaled.
+        const uint8_t shift = !seg.header().syn && _window_scaling() ? _window_scale : 0;
+        seg.header().win = min(_receiver.window_size() >> shift, size_t{numeric_limits<uint16_t>::max()});
+        if (seg.header().ack) {
+            _unacked_bytes = 0;
+            _ack_delay_elapsed.reset();
+            _advertised_window = _receiver.window_size();
+            if (_cfg.recv_autotuning && !_rtt_mark.has_value()) {
+                _rtt_mark = {_receiver.stream_out().bytes_written() + _advertised_window, _sender.timestamp()};
+            }
+        }
+        if (_cfg.sack && _peer_sack_permitted) {
+            seg.header().sack_blocks = _receiver.sack_blocks(TCPHeader::MAX_SACK_BLOCKS);
+        }
+        _segments_out.push(move(seg));
     }
     clean_shutdown();
 }
 
+//! \details RFC 1122: an ACK may be delayed, but not for long, and at least every second full-size
+//! segment is acknowledged (TCPConfig::ack_every). ACKs for out-of-order data (or data that fills
+//! a hole), SYNs and FINs are never delayed.
+bool TCPConnection::_delay_ack(const TCPSegment &seg, const bool in_order) {
+    if (_cfg.delayed_ack_ms == 0 || !in_order || seg.header().syn || seg.header().fin) {
+        return false;
+    }
+    _unacked_bytes += seg.payload().size();
+    if (_unacked_bytes >= _cfg.ack_every * _peer_mss) {
+        return false;
+    }
+    if (!_ack_delay_elapsed.has_value()) {
+        _ack_delay_elapsed = 0;
+    }
+    return true;
+}
+
+void TCPConnection::_tick_delayed_ack(const size_t ms_since_last_tick) {
+    if (!_ack_delay_elapsed.has_value()) {
+        return;
+    }
+    _ack_delay_elapsed.value() += ms_since_last_tick;
+    // A reader that frees up two segments' worth of window shouldn't wait on the delay to say so.
+    const bool window_opened = _receiver.window_size() >= _advertised_window + 2 * _peer_mss;
+    if (_ack_delay_elapsed.value() >= _cfg.delayed_ack_ms || window_opened) {
+        _sender.send_empty_segment();
+    }
+}
+
+//! \details Receiver-side silly window avoidance (RFC 1122, 4.2.3.3): the window is reported once its right
+//! edge has moved by min(half the buffer, one MSS), and has at least doubled, so a reader that keeps up with
+//! a bulk transfer doesn't cause an extra ACK per read. Without this, a peer that saw a zero window would
+//! only learn it has reopened from its next probe.
+void TCPConnection::_send_window_update() {
+    // A held ACK has its own check, and a segment about to go out carries the window anyway.
+    if (!_receiver.ackno().has_value() || _receiver.stream_out().input_ended() || _ack_delay_elapsed.has_value() ||
+        !_sender.segments_out().empty()) {
+        return;
+    }
+    const size_t window = _receiver.window_size();
+    const size_t threshold = min(_cfg.recv_capacity / 2, _peer_mss);
+    if (window >= _advertised_window + threshold && window >= 2 * _advertised_window) {
+        _sender.send_empty_segment();
+    }
+}
+
+//! \details Data from beyond the right edge of a window can only have been sent after the peer saw that
+//! window, so it arrives at least one RTT after it was advertised (as in Linux's receiver RTT estimate).
+//! It can arrive later, if the sender wasn't limited by the window, so decreases are taken at once and
+//! increases only slowly.
+void TCPConnection::_sample_receiver_rtt() {
+    if (!_rtt_mark.has_value() || _receiver.stream_out().bytes_written() <= _rtt_mark->first) {
+        return;
+    }
+    const uint32_t sample = max<uint32_t>(_sender.timestamp() - _rtt_mark->second, 1);
+    if (!_receiver_rtt.has_value() || sample < _receiver_rtt.value()) {
+        _receiver_rtt = sample;
+    } else {
+        _receiver_rtt = (7 * _receiver_rtt.value() + sample) / 8;
+    }
+    _rtt_mark.reset();
+}
+
+bool TCPConnection::_idle_shrink_pending() const {
+    return _cfg.recv_autotuning && _receiver.capacity() > _cfg.recv_capacity && _receiver.stream_out().buffer_empty() &&
+           _receiver.unassembled_bytes() == 0 && !_receiver.stream_out().input_ended();
+}
+
+//! \details Like Linux's dynamic right-sizing: the window needs to cover what the application drains in
+//! one RTT for the data in flight, and as much again so it can fall behind for a while without stalling
+//! the sender. The buffer only grows when the application drains more than ever before, by at most a
+//! doubling per RTT, and never past TCPConfig::recv_capacity_max.
+void TCPConnection::_autotune_receive_buffer() {
+    if (!_cfg.recv_autotuning || !_receiver.ackno().has_value()) {
+        return;
+    }
+    if (_time_since_last_segment_received >= TCPConfig::RECV_IDLE_MS) {
+        if (_idle_shrink_pending()) {
+            // Give the memory back, and tell the peer the window is smaller now.
+            _receiver.set_capacity(_cfg.recv_capacity);
+            _reserve_buffers(_receiver.capacity(), _sender.stream_in().capacity());
+            _drained_per_rtt = 0;
+            _sender.send_empty_segment();
+        }
+        return;
+    }
+
+    const ByteStream &inbound = _receiver.stream_out();
+    if (!_receiver_rtt.has_value() || _sender.timestamp() - _drained_mark_time < _receiver_rtt.value()) {
+        return;
+    }
+    const size_t drained = inbound.bytes_read() - _drained_mark;
+    if (drained > _drained_per_rtt) {
+        _drained_per_rtt = drained;
+        const size_t ceiling = max(_cfg.recv_capacity_max, _cfg.recv_capacity);
+        const size_t capacity = min(max(2 * drained, _receiver.capacity()), ceiling);
+        if (_reserve_buffers(capacity, _sender.stream_in().capacity())) {
+            _receiver.set_capacity(capacity);
+        }
+    }
+    _drained_mark = inbound.bytes_read();
+    _drained_mark_time = _sender.timestamp();
+}
+
+//! \details Like Linux's send-buffer autotuning: the application can queue a whole window while another
+//! is in flight, and keep up as slow start doubles the window each RTT.
+void TCPConnection::_autotune_send_buffer() {
+    ByteStream &outbound = _sender.stream_in();
+    if (!_cfg.send_autotuning || outbound.input_ended()) {
+        return;
+    }
+    const size_t ceiling = max(_cfg.send_capacity_max, _cfg.send_capacity);
+    const size_t capacity = min<uint64_t>(2 * _sender.send_window(), ceiling);
+    if (capacity > outbound.capacity() && _reserve_buffers(_receiver.capacity(), capacity)) {
+        outbound.set_capacity(capacity);
+    }
+}
+
+bool TCPConnection::_reserve_buffers(const size_t recv_capacity, const size_t send_capacity) {
+    return _memory.resize(recv_capacity + send_capacity);
+}
+
+//! \details Like Linux's `tcp_mem`: under pressure, grown buffers shrink back to their configured sizes;
+//! past the limit, both shrink to what they hold, which closes the receive window. They are restored once
+//! the pressure is relieved. A smaller window is advertised at once, so the peer stops sending into it.
+void TCPConnection::_balance_memory() {
+    if (!_cfg.memory_budget) {
+        return;
+    }
+    const MemoryBudget &budget = *_cfg.memory_budget;
+    ByteStream &outbound = _sender.stream_in();
+    const size_t window_before = _receiver.window_size();
+    if (budget.exhausted()) {
+        _receiver.set_capacity(0);
+        outbound.set_capacity(0);
+    } else if (budget.under_pressure()) {
+        _receiver.set_capacity(min(_receiver.capacity(), _cfg.recv_capacity));
+        outbound.set_capacity(min(outbound.capacity(), _cfg.send_capacity));
+    } else {
+        const size_t recv_capacity = max(_receiver.capacity(), _cfg.recv_capacity);
+        const size_t send_capacity = max(outbound.capacity(), _cfg.send_capacity);
+        if (_reserve_buffers(recv_capacity, send_capacity)) {
+            _receiver.set_capacity(recv_capacity);
+            outbound.set_capacity(send_capacity);
+        }
+        return;
+    }
+    _reserve_buffers(_receiver.capacity(), outbound.capacity());
+    if (_receiver.window_size() < window_before && _receiver.ackno().has_value()) {
+        _sender.send_empty_segment();
+    }
+}
+
 void TCPConnection::clean_shutdown() {
     // PreReq #1: The inbound stream has been fully assembled and has ended;
     // PreReq #2: The outbound stream has been ended by the local application and fully sent(including
@@ -206,13 +469,13 @@ void TCPConnection::send_rst_segment() {
         _sender.send_empty_segment();
     }
 
-    TCPSegment seg = _sender.segments_out().front();
+    TCPSegment seg = move(_sender.segments_out().front());
     _sender.segments_out().pop();
     seg.header().ack = true;
     if (_receiver.ackno().has_value())
         seg.header().ackno = _receiver.ackno().value();
     seg.header().win = min(_receiver.window_size(), numeric_limits<size_t>::max());
     seg.header().rst = true;
-    _segments_out.emplace(seg);
+    _segments_out.push(move(seg));
     unclean_shutdown();
 }
@@ -6,12 +6,17 @@
 #include "tcp_sender.hh"
 #include "tcp_state.hh"
 
+#include <algorithm>
+#include <utility>
+
 //! \brief A complete endpoint of a TCP connection
 class TCPConnection {
   private:
     TCPConfig _cfg;
-    TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPReceiver _receiver{_cfg.recv_capacity,
+                          _cfg.ring_reassembly ? StreamReassembler::Storage::Ring
+                                               : StreamReassembler::Storage::Segments};
+    TCPSender _sender{_cfg};
 
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> _segments_out{};
@@ -27,9 +32,84 @@ class TCPConnection {
     //! Number of milliseconds since the last segment was received.
     size_t _time_since_last_segment_received{0};
 
+    //! \name Delayed ACKs
+    //!@{
+    size_t _unacked_bytes{0};                    //!< In-order bytes received since the last ACK went out
+    std::optional<size_t> _ack_delay_elapsed{};  //!< Milliseconds an ACK has been held, if one is being held
+    size_t _advertised_window{0};                //!< The receive window in the last ACK sent
+    //!@}
+
+    //! \name Receive-buffer autotuning (dynamic right-sizing)
+    //!@{
+    std::optional<std::pair<uint64_t, uint32_t>> _rtt_mark{};  //!< A window's right edge, and when it was advertised
+    std::optional<uint32_t> _receiver_rtt{};                   //!< The RTT as seen by the receiver, in milliseconds
+    uint64_t _drained_mark{0};                                 //!< Bytes the application had read when the RTT began
+    uint32_t _drained_mark_time{0};                            //!< When that RTT began
+    size_t _drained_per_rtt{0};                                //!< The most the application has read in one RTT
+    //!@}
+
+    //! The capacity of both buffers, charged to TCPConfig::memory_budget
+    MemoryBudget::Reservation _memory{_cfg.memory_budget, _cfg.recv_capacity + _cfg.send_capacity};
+
+    //! Whether the peer's SYN carried the SACK-permitted option.
+    bool _peer_sack_permitted{false};
+
+    //! Whether the peer's SYN carried the timestamps option.
+    bool _peer_timestamps{false};
+
+    //! The largest payload the peer sends in one segment: our MSS, or the smaller one on its SYN.
+    size_t _peer_mss{_cfg.mss};
+
+    //! The shift count we scale our advertised window by, once window scaling is agreed.
+    uint8_t _window_scale{_window_scale_for(
+        _cfg.recv_autotuning ? std::max(_cfg.recv_capacity, _cfg.recv_capacity_max) : _cfg.recv_capacity)};
+
+    //! The peer's window scale option, from its SYN.
+    std::optional<uint8_t> _peer_window_scale{};
+
+    //! The smallest shift that fits a window of `capacity` bytes in the 16-bit window field.
+    static uint8_t _window_scale_for(const size_t capacity);
+
+    //! Whether both sides sent the window scale option, so windows are scaled past the SYNs.
+    bool _window_scaling() const { return _cfg.window_scaling && _peer_window_scale.has_value(); }
+
+    //! Whether both sides sent the timestamps option, so every segment carries one.
+    bool _timestamps() const { return _cfg.timestamps && _peer_timestamps; }
+
+    //! PAWS (RFC 7323): whether `seg` carries a timestamp older than the latest one accepted.
+    bool _stale_timestamp(const TCPSegment &seg) const;
+
     //! Send segments.
     void send_segments();
 
+    //! Whether the ACK for `seg`, which arrived in order if `in_order`, may be held back (delayed ACKs).
+    bool _delay_ack(const TCPSegment &seg, const bool in_order);
+
+    //! Advance the delayed-ACK timer, and send the held ACK if it expires or the window opened up.
+    void _tick_delayed_ack(const size_t ms_since_last_tick);
+
+    //! Send a window update if the application has read enough to reopen a small or closed window.
+    void _send_window_update();
+
+    //! Autotuning: take an RTT sample once data arrives from beyond the window advertised at the mark.
+    void _sample_receiver_rtt();
+
+    //! Autotuning: once per RTT, grow the receive buffer to what the application drains in two RTTs;
+    //! shrink it back to its initial size once the connection goes idle.
+    void _autotune_receive_buffer();
+
+    //! Autotuning: whether the receive buffer is grown, and empty, so it will shrink once the connection idles.
+    bool _idle_shrink_pending() const;
+
+    //! Autotuning: grow the send buffer to twice the window the sender may fill.
+    void _autotune_send_buffer();
+
+    //! Reserve memory for buffers of these capacities; false if the memory budget can't grow to them.
+    bool _reserve_buffers(const size_t recv_capacity, const size_t send_capacity);
+
+    //! Shrink the buffers as the memory budget comes under pressure, and restore them once it is relieved.
+    void _balance_memory();
+
     //! Clean shutdown if necessary.
     void clean_shutdown();
 
@@ -55,6 +135,10 @@ class TCPConnection {
 
     //! \brief Shut down the outbound byte stream (still allows reading incoming data)
     void end_input_stream();
+
+    //! \brief Cork the connection, so only full segments are sent, or uncork it and send what was held back
+    //! \note Like Linux's TCP_CORK, a partial segment is held for at most TCPConfig::CORK_TIMEOUT_MS.
+    void set_corked(const bool corked);
     //!@}
 
     //! \name "Output" interface for the reader
@@ -73,6 +157,12 @@ class TCPConnection {
     size_t unassembled_bytes() const;
     //! \brief Number of milliseconds since the last segment was received
     size_t time_since_last_segment_received() const;
+    //! \brief the sender's round-trip time estimate (empty unless TCPConfig::rtt_estimation is set)
+    const std::optional<RTTEstimator> &rtt_estimator() const { return _sender.rtt_estimator(); }
+    //! \brief number of segments the sender retransmitted on duplicate ACKs
+    uint64_t fast_retransmissions() const { return _sender.fast_retransmissions(); }
+    //! \brief number of segments the sender retransmitted after a timeout
+    uint64_t timeout_retransmissions() const { return _sender.timeout_retransmissions(); }
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
     //!@}
@@ -86,6 +176,12 @@ class TCPConnection {
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! \brief Milliseconds until the next tick that has something to do, or empty if there is none
+    //! \details Covers the sender's timers, a delayed ACK, and lingering after both streams finish.
+    //! An owner may sleep this long (unless a segment arrives or the application acts) instead of
+    //! ticking at a fixed interval.
+    std::optional<size_t> time_until_next_timer() const;
+
     //! \brief TCPSegments that the TCPConnection has enqueued for transmission.
     //! \note The owner or operating system will dequeue these and
     //! put each one into the payload of a lower-layer datagram (usually Internet datagrams (IP),
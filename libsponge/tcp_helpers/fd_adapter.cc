@@ -45,12 +45,18 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
     return seg;
 }
 
-//! Serialize a TCP segment and send it as the payload of a UDP datagram.
+//! Serialize a TCP segment and send it as the payload of a UDP datagram (one per wire segment).
 //! \param[in] seg is the TCP segment to write
 void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
-    _sock.sendto(config().destination, seg.serialize(0));
+    if (seg.gso_size() == 0) {
+        _sock.sendto(config().destination, seg.serialize(0));
+        return;
+    }
+    for (const auto &wire_seg : seg.wire_segments()) {
+        _sock.sendto(config().destination, wire_seg.serialize(0));
+    }
 }
 
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
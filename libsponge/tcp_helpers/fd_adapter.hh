@@ -40,6 +40,9 @@ class FdAdapterBase {
 
     //! Called periodically when time elapses
     void tick(const size_t) {}
+
+    //! Milliseconds until the adapter next needs a tick, or empty if it has no timers
+    std::optional<size_t> time_until_next_timer() const { return {}; }
 };
 
 //! \brief A FD adaptor that reads and writes TCP segments in UDP payloads
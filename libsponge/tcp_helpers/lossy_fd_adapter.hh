@@ -47,13 +47,21 @@ class LossyFdAdapter {
         return ret;
     }
 
-    //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
-    //! \param[in] seg is the packet to either write or drop
+    //! \brief Write to the underlying AdapterT instance, potentially dropping the datagrams to be written
+    //! \param[in] seg is the packet to either write or drop (each of its wire segments on its own)
+    //! \details The wire segments have nothing left to split, so the underlying adapter writes them as they are.
     void write(TCPSegment &seg) {
-        if (_should_drop(true)) {
+        if (seg.gso_size() == 0) {
+            if (not _should_drop(true)) {
+                _adapter.write(seg);
+            }
             return;
         }
-        return _adapter.write(seg);
+        for (auto &wire_seg : seg.wire_segments()) {
+            if (not _should_drop(true)) {
+                _adapter.write(wire_seg);
+            }
+        }
     }
 
     //! \name
@@ -66,6 +74,9 @@ class LossyFdAdapter {
     void tick(const size_t ms_since_last_tick) {
         _adapter.tick(ms_since_last_tick);
     }  //!< FdAdapterBase::tick passthrough
+    std::optional<size_t> time_until_next_timer() const {
+        return _adapter.time_until_next_timer();
+    }  //!< FdAdapterBase::time_until_next_timer passthrough
     //!@}
 };
 
@@ -2,24 +2,65 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "memory_budget.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
 
 //! Config for TCP sender and receiver
 class TCPConfig {
   public:
+    //! Congestion control algorithms for the TCPSender
+    enum class CongestionControl {
+        None,     //!< Limited only by the receiver's window
+        NewReno,  //!< Slow start, congestion avoidance and NewReno fast recovery
+        Cubic,    //!< CUBIC window growth with NewReno loss recovery
+        Bbr       //!< Paced at the estimated bottleneck bandwidth, in flight a multiple of the BDP
+    };
+
     static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< Default capacity
-    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet
+    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Default MSS, conservative for real Internet
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr unsigned DUP_ACK_THRESHOLD = 3;   //!< Duplicate ACKs that trigger a fast retransmit
+    static constexpr uint16_t MIN_RTO_DFLT = 200;      //!< Default lower bound on an estimated RTO
+    static constexpr uint16_t MAX_RTO_DFLT = 60000;    //!< Default upper bound on an estimated RTO
+    static constexpr unsigned ACK_EVERY_DFLT = 2;      //!< Full-size segments per delayed ACK (RFC 1122)
+    static constexpr size_t GSO_MAX_SIZE = 65536;      //!< Most payload in one segment with segmentation offload
+    static constexpr uint16_t CORK_TIMEOUT_MS = 200;   //!< Longest a corked partial segment is held (as in Linux)
+    static constexpr size_t RECV_CAPACITY_MAX_DFLT = 4 * 1024 * 1024;  //!< Default ceiling of an autotuned buffer
+    static constexpr uint16_t RECV_IDLE_MS = 1000;  //!< Idle time after which an autotuned buffer shrinks back
+    static constexpr size_t SEND_CAPACITY_MAX_DFLT = 4 * 1024 * 1024;  //!< Default ceiling of an autotuned buffer
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
+    size_t mss = MAX_PAYLOAD_SIZE;            //!< Largest payload to send, and the MSS advertised on our SYN
     std::optional<WrappingInt32> fixed_isn{};
+    bool ring_reassembly = false;  //!< Reassemble in place in a ring with a presence bitmap, not a segment set
+    CongestionControl congestion_control = CongestionControl::None;  //!< Sender congestion control
+    bool rtt_estimation = false;          //!< Derive the RTO from measured RTTs (RFC 6298) instead of fixing it
+    uint16_t min_rto = MIN_RTO_DFLT;      //!< Lower bound on the estimated RTO, in milliseconds
+    uint16_t max_rto = MAX_RTO_DFLT;      //!< Upper bound on the estimated and backed-off RTO, in milliseconds
+    bool sack = false;                    //!< Negotiate selective acknowledgments (RFC 2018) and recover with them
+    bool window_scaling = false;          //!< Negotiate window scaling (RFC 7323), for windows beyond 64 KiB
+    bool timestamps = false;              //!< Negotiate timestamps (RFC 7323) for RTT samples and PAWS
+    uint16_t delayed_ack_ms = 0;          //!< Hold ACKs of in-order data this long (0: ACK every segment at once)
+    unsigned ack_every = ACK_EVERY_DFLT;  //!< With delayed ACKs, ACK once this many full-size segments arrive
+    bool segmentation_offload = false;    //!< Send segments of up to GSO_MAX_SIZE for the adapter to split at the MSS
+    bool receive_offload = false;         //!< Coalesce bursts of in-order segments before TCP processes them (GRO)
+    bool nagle = false;                   //!< Hold back a partial segment while data is unacknowledged (RFC 896)
+    bool cork = false;                    //!< Start corked: send only full segments (see TCPConnection::set_corked)
+    bool persist_timer = false;           //!< Back off zero-window probes up to max_rto, and never give up on them
+    bool recv_autotuning = false;         //!< Grow the receive buffer with the application's drain rate (DRS)
+    size_t recv_capacity_max = RECV_CAPACITY_MAX_DFLT;  //!< Ceiling of the receive buffer with autotuning
+    bool send_autotuning = false;  //!< Grow the send buffer to twice the window the sender may fill
+    size_t send_capacity_max = SEND_CAPACITY_MAX_DFLT;  //!< Ceiling of the send buffer with autotuning
+    bool retransmit_collapse = false;  //!< Merge small unacknowledged segments into one MSS when retransmitting
+    std::shared_ptr<MemoryBudget> memory_budget{};  //!< Buffer memory shared with other connections, if limited
 };
 
 //! Config for classes derived from FdAdapter
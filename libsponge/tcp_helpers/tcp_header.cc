@@ -1,9 +1,102 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
 
+namespace {
+//! \name TCP option kinds (RFC 793, RFC 7323 and RFC 2018)
+//!@{
+constexpr uint8_t OPT_EOL = 0;
+constexpr uint8_t OPT_NOP = 1;
+constexpr uint8_t OPT_MSS = 2;
+constexpr uint8_t OPT_WINDOW_SCALE = 3;
+constexpr uint8_t OPT_SACK_PERMITTED = 4;
+constexpr uint8_t OPT_SACK = 5;
+constexpr uint8_t OPT_TIMESTAMPS = 8;
+//!@}
+
+constexpr size_t SACK_BLOCK_LENGTH = 8;  //!< Each SACK block is two 32-bit sequence numbers
+
+//! \brief Bytes the options other than SACK occupy, including the NOP padding serialize() adds
+size_t fixed_options_length(const TCPHeader &hdr) {
+    return (hdr.mss.has_value() ? 4 : 0) + (hdr.window_scale.has_value() ? 4 : 0) +
+           (hdr.timestamp.has_value() ? 12 : 0) + (hdr.sack_permitted ? 4 : 0);
+}
+
+//! \brief How many of the SACK blocks in `hdr` fit in the option space left by the other options
+size_t sack_blocks_sent(const TCPHeader &hdr) {
+    const size_t room = TCPHeader::MAX_OPTIONS_LENGTH - fixed_options_length(hdr) - 4;
+    return min(hdr.sack_blocks.size(), room / SACK_BLOCK_LENGTH);
+}
+
+//! \brief Bytes the options in `hdr` occupy, including the NOP padding serialize() adds
+size_t options_length(const TCPHeader &hdr) {
+    const size_t nblocks = sack_blocks_sent(hdr);
+    return fixed_options_length(hdr) + (nblocks > 0 ? 4 + SACK_BLOCK_LENGTH * nblocks : 0);
+}
+
+//! \brief The big-endian 16-bit field at offset `at` of `opts`
+uint16_t u16_at(const string_view opts, const size_t at) {
+    return static_cast<uint16_t>(static_cast<uint8_t>(opts[at]) << 8 | static_cast<uint8_t>(opts[at + 1]));
+}
+
+//! \brief The big-endian 32-bit field at offset `at` of `opts`
+uint32_t u32_at(const string_view opts, const size_t at) {
+    return static_cast<uint32_t>(u16_at(opts, at)) << 16 | u16_at(opts, at + 2);
+}
+
+//! \brief Parse the option area of a TCP header into `hdr`
+//! \details Unknown options are skipped. A malformed option (bad length, or running off the end of the
+//!          option area) ends option processing; whatever was parsed before it is kept.
+void parse_options(const string_view opts, TCPHeader &hdr) {
+    size_t i = 0;
+    while (i < opts.size()) {
+        const uint8_t kind = opts[i];
+        if (kind == OPT_EOL) {
+            return;
+        }
+        if (kind == OPT_NOP) {
+            ++i;
+            continue;
+        }
+        if (i + 1 >= opts.size()) {
+            return;
+        }
+        const uint8_t len = opts[i + 1];
+        if (len < 2 or i + len > opts.size()) {
+            return;
+        }
+        if (kind == OPT_MSS and len == 4) {
+            hdr.mss = u16_at(opts, i + 2);
+        } else if (kind == OPT_WINDOW_SCALE and len == 3) {
+            //! RFC 7323: a shift above 14 is treated as 14.
+            hdr.window_scale = min(static_cast<uint8_t>(opts[i + 2]), TCPHeader::MAX_WINDOW_SCALE);
+        } else if (kind == OPT_TIMESTAMPS and len == 10) {
+            TCPTimestamp &ts = hdr.timestamp.emplace();
+            ts.value = u32_at(opts, i + 2);
+            ts.echo = u32_at(opts, i + 6);
+        } else if (kind == OPT_SACK_PERMITTED and len == 2) {
+            hdr.sack_permitted = true;
+        } else if (kind == OPT_SACK and (len - 2) % SACK_BLOCK_LENGTH == 0) {
+            for (size_t at = i + 2; at < i + len; at += SACK_BLOCK_LENGTH) {
+                SackBlock block;
+                block.begin = WrappingInt32{u32_at(opts, at)};
+                block.end = WrappingInt32{u32_at(opts, at + 4)};
+                hdr.sack_blocks.push_back(block);
+            }
+        }
+        i += len;
+    }
+}
+}  // namespace
+
+uint8_t TCPHeader::data_offset() const {
+    const size_t needed = (LENGTH + options_length(*this) + 3) / 4;
+    return max<size_t>(doff, needed);
+}
+
 //! \param[in,out] p is a NetParser from which the TCP fields will be extracted
 //! \returns a ParseResult indicating success or the reason for failure
 //! \details It is important to check for (at least) the following potential errors
@@ -37,8 +130,17 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    // parse any options, then skip past the rest of the header
+    mss.reset();
+    window_scale.reset();
+    timestamp.reset();
+    sack_permitted = false;
+    sack_blocks.clear();
+    const size_t opts_len = doff * 4 - TCPHeader::LENGTH;
+    if (not p.error() and p.buffer().size() >= opts_len) {
+        parse_options(p.buffer().str().substr(0, opts_len), *this);
+    }
+    p.remove_prefix(opts_len);
 
     if (p.error()) {
         return p.get_error();
@@ -54,14 +156,19 @@ string TCPHeader::serialize() const {
         throw runtime_error("TCP header too short");
     }
 
+    const uint8_t offset = data_offset();
+    if (offset > (LENGTH + MAX_OPTIONS_LENGTH) / 4) {
+        throw runtime_error("TCP options too long");
+    }
+
     string ret;
-    ret.reserve(4 * doff);
+    ret.reserve(4 * offset);
 
     NetUnparser::u16(ret, sport);              // source port
     NetUnparser::u16(ret, dport);              // destination port
     NetUnparser::u32(ret, seqno.raw_value());  // sequence number
     NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    NetUnparser::u8(ret, offset << 4);         // data offset
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
@@ -72,7 +179,41 @@ string TCPHeader::serialize() const {
 
     NetUnparser::u16(ret, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    // options, each padded with NOPs to a 32-bit boundary
+    if (mss.has_value()) {
+        NetUnparser::u8(ret, OPT_MSS);
+        NetUnparser::u8(ret, 4);
+        NetUnparser::u16(ret, mss.value());
+    }
+    if (window_scale.has_value()) {
+        for (const uint8_t b : {OPT_NOP, OPT_WINDOW_SCALE, uint8_t{3}, window_scale.value()}) {
+            NetUnparser::u8(ret, b);
+        }
+    }
+    if (timestamp.has_value()) {
+        for (const uint8_t b : {OPT_NOP, OPT_NOP, OPT_TIMESTAMPS, uint8_t{10}}) {
+            NetUnparser::u8(ret, b);
+        }
+        NetUnparser::u32(ret, timestamp->value);
+        NetUnparser::u32(ret, timestamp->echo);
+    }
+    if (sack_permitted) {
+        for (const uint8_t b : {OPT_NOP, OPT_NOP, OPT_SACK_PERMITTED, uint8_t{2}}) {
+            NetUnparser::u8(ret, b);
+        }
+    }
+    const size_t nblocks = sack_blocks_sent(*this);
+    if (nblocks > 0) {
+        for (const uint8_t b : {OPT_NOP, OPT_NOP, OPT_SACK, static_cast<uint8_t>(2 + SACK_BLOCK_LENGTH * nblocks)}) {
+            NetUnparser::u8(ret, b);
+        }
+        for (size_t i = 0; i < nblocks; ++i) {
+            NetUnparser::u32(ret, sack_blocks[i].begin.raw_value());
+            NetUnparser::u32(ret, sack_blocks[i].end.raw_value());
+        }
+    }
+
+    ret.resize(4 * offset);  // expand header to advertised size
 
     return ret;
 }
@@ -90,13 +231,44 @@ string TCPHeader::to_string() const {
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
        << "TCP uptr: " << +uptr << '\n';
+    if (mss.has_value()) {
+        ss << "TCP option: MSS " << dec << mss.value() << hex << '\n';
+    }
+    if (window_scale.has_value()) {
+        ss << "TCP option: window scale " << dec << +window_scale.value() << hex << '\n';
+    }
+    if (timestamp.has_value()) {
+        ss << "TCP option: timestamps " << dec << timestamp->value << " echo " << timestamp->echo << hex << '\n';
+    }
+    if (sack_permitted) {
+        ss << "TCP option: SACK permitted\n";
+    }
+    for (const auto &block : sack_blocks) {
+        ss << "TCP option: SACK " << block.begin << "-" << block.end << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (mss.has_value()) {
+        ss << ",mss=" << mss.value();
+    }
+    if (window_scale.has_value()) {
+        ss << ",wscale=" << +window_scale.value();
+    }
+    if (timestamp.has_value()) {
+        ss << ",ts=" << timestamp->value << "/" << timestamp->echo;
+    }
+    if (sack_permitted) {
+        ss << ",sackOK";
+    }
+    for (const auto &block : sack_blocks) {
+        ss << ",sack=" << block.begin << "-" << block.end;
+    }
+    ss << ")";
     return ss.str();
 }
 
@@ -104,5 +276,6 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && mss == other.mss && window_scale == other.window_scale &&
+           timestamp == other.timestamp && sack_permitted == other.sack_permitted && sack_blocks == other.sack_blocks;
 }
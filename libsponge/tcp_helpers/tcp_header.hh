@@ -4,10 +4,33 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <vector>
+
+//! \brief A range of sequence numbers received beyond the ackno, reported in a SACK option (RFC 2018)
+struct SackBlock {
+    WrappingInt32 begin{0};  //!< sequence number of the first byte in the block
+    WrappingInt32 end{0};    //!< sequence number just past the last byte in the block
+
+    bool operator==(const SackBlock &other) const { return begin == other.begin && end == other.end; }
+};
+
+//! \brief The timestamps option (RFC 7323): the sender's clock, and the latest clock value it received
+struct TCPTimestamp {
+    uint32_t value = 0;  //!< TSval: the sender's timestamp clock when the segment was sent
+    uint32_t echo = 0;   //!< TSecr: the TSval most recently received from the peer
+
+    bool operator==(const TCPTimestamp &other) const { return value == other.value && echo == other.echo; }
+};
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note Of the TCP options, only MSS (RFC 793), window scale and timestamps (RFC 7323), SACK-permitted and
+//!       SACK (RFC 2018) are supported; others are skipped
 struct TCPHeader {
-    static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t LENGTH = 20;              //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t MAX_OPTIONS_LENGTH = 40;  //!< Room for options: doff is at most 15 words
+    static constexpr size_t MAX_SACK_BLOCKS = 4;      //!< Most SACK blocks that fit in the option space
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;   //!< Largest window shift allowed (RFC 7323)
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -50,6 +73,18 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \name TCP options
+    //!@{
+    std::optional<uint16_t> mss{};            //!< Maximum segment size option, only valid on a SYN
+    std::optional<uint8_t> window_scale{};    //!< Window scale option (shift count), only valid on a SYN
+    std::optional<TCPTimestamp> timestamp{};  //!< Timestamps option
+    bool sack_permitted = false;              //!< SACK-permitted option, only valid on a SYN
+    std::vector<SackBlock> sack_blocks{};     //!< SACK option (only as many blocks as fit are sent)
+    //!@}
+
+    //! \brief The data offset serialize() writes: `doff`, or more if the options need it
+    uint8_t data_offset() const;
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
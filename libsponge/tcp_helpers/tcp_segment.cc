@@ -3,6 +3,7 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <variant>
 
 using namespace std;
@@ -22,6 +23,32 @@ ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer
     return p.get_error();
 }
 
+vector<TCPSegment> TCPSegment::wire_segments() const {
+    if (_gso_size == 0 or _payload.size() <= _gso_size) {
+        TCPSegment seg = *this;
+        seg._gso_size = 0;
+        return {seg};
+    }
+
+    vector<TCPSegment> ret;
+    ret.reserve((_payload.size() + _gso_size - 1) / _gso_size);
+    for (size_t offset = 0; offset < _payload.size(); offset += _gso_size) {
+        const size_t piece_size = min(_gso_size, _payload.size() - offset);
+        const bool last = offset + piece_size == _payload.size();
+
+        TCPSegment &piece = ret.emplace_back();
+        piece._header = _header;
+        piece._header.seqno = _header.seqno + (_header.syn and offset > 0 ? 1 : 0) + offset;
+        piece._header.syn = _header.syn and offset == 0;
+        piece._header.psh = _header.psh and last;
+        piece._header.fin = _header.fin and last;
+        piece._payload = _payload;
+        piece._payload.remove_prefix(offset);
+        piece._payload.remove_suffix(_payload.size() - offset - piece_size);
+    }
+    return ret;
+}
+
 size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
@@ -5,12 +5,14 @@
 #include "tcp_header.hh"
 
 #include <cstdint>
+#include <vector>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
   private:
     TCPHeader _header{};
     Buffer _payload{};
+    size_t _gso_size{};  //!< If nonzero, the most payload bytes per segment on the wire
 
   public:
     //! \brief Parse the segment from a string
@@ -26,8 +28,17 @@ class TCPSegment {
 
     const Buffer &payload() const { return _payload; }
     Buffer &payload() { return _payload; }
+
+    size_t gso_size() const { return _gso_size; }
+    void set_gso_size(const size_t gso_size) { _gso_size = gso_size; }
     //!@}
 
+    //! \brief The segments to put on the wire for this one (segmentation offload)
+    //! \details Without a GSO size, or with a payload that fits in one, that is just this segment.
+    //!          Otherwise the payload is split into GSO-sized pieces sharing its storage, each under a
+    //!          copy of the header with its own seqno; only the last piece keeps the PSH and FIN flags.
+    std::vector<TCPSegment> wire_segments() const;
+
     //! \brief Segment's length in sequence space
     //! \note Equal to payload length plus one byte if SYN is set, plus one byte if FIN is set
     size_t length_in_sequence_space() const;
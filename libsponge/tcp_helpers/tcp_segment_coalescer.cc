@@ -0,0 +1,53 @@
+#include "tcp_segment_coalescer.hh"
+
+#include <utility>
+
+using namespace std;
+
+//! \details Like Linux's tcp_gro_receive(): only in-order data segments without SYN, RST or URG are
+//! merged, and nothing is merged after a FIN. A segment whose header says anything beyond what the
+//! first segment's header already says (a different ackno or window, new SACK blocks or timestamps)
+//! is kept separate so no acknowledgment information is lost.
+bool TCPSegmentCoalescer::_continues_pending(const TCPSegment &seg) const {
+    if (not _pending.has_value()) {
+        return false;
+    }
+    const TCPHeader &first = _pending->header();
+    const TCPHeader &hdr = seg.header();
+    return not first.fin and not hdr.syn and not hdr.rst and not hdr.urg and seg.payload().size() > 0 and
+           hdr.seqno == first.seqno + _pending_payload.size() and hdr.sport == first.sport and
+           hdr.dport == first.dport and hdr.ack == first.ack and hdr.ackno == first.ackno and hdr.win == first.win and
+           hdr.timestamp == first.timestamp and hdr.sack_blocks == first.sack_blocks and
+           _pending_payload.size() + seg.payload().size() <= MAX_PAYLOAD;
+}
+
+//! \param[in] seg the segment just received
+void TCPSegmentCoalescer::push(TCPSegment &&seg) {
+    if (_continues_pending(seg)) {
+        _pending_payload.append(seg.payload());
+        _pending->header().psh |= seg.header().psh;
+        _pending->header().fin = seg.header().fin;
+        return;
+    }
+
+    flush();
+    if (seg.header().syn or seg.header().rst or seg.header().urg or seg.payload().size() == 0) {
+        _segments_out.push(move(seg));
+        return;
+    }
+    _pending_payload = seg.payload();
+    _pending = move(seg);
+}
+
+void TCPSegmentCoalescer::flush() {
+    if (not _pending.has_value()) {
+        return;
+    }
+    //! A lone segment keeps its payload; a merged one gets the payloads copied together once.
+    if (_pending_payload.buffers().size() > 1) {
+        _pending->payload() = Buffer{_pending_payload.concatenate()};
+    }
+    _segments_out.push(move(_pending.value()));
+    _pending.reset();
+    _pending_payload = BufferList{};
+}
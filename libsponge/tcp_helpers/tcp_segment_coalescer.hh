@@ -0,0 +1,39 @@
+#ifndef SPONGE_LIBSPONGE_TCP_SEGMENT_COALESCER_HH
+#define SPONGE_LIBSPONGE_TCP_SEGMENT_COALESCER_HH
+
+#include "buffer.hh"
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <optional>
+#include <queue>
+
+//! \brief Generic receive offload: merges runs of back-to-back segments into one larger segment
+//! \details Segments are pushed in the order they arrived. A segment that continues the one being
+//! built (same ports, flags, ackno, window and options; its seqno right after the last payload byte)
+//! has its payload appended to it. Anything else first flushes the segment being built to
+//! segments_out(). TCP then processes a burst of segments once, as if the peer had sent one.
+class TCPSegmentCoalescer {
+  private:
+    std::optional<TCPSegment> _pending{};  //!< The segment being built, with the first segment's header
+    BufferList _pending_payload{};         //!< The payloads of the segments merged into it, in order
+    std::queue<TCPSegment> _segments_out{};
+
+    //! Whether `seg` can be appended to the segment being built
+    bool _continues_pending(const TCPSegment &seg) const;
+
+  public:
+    //! Most payload in one coalesced segment
+    static constexpr size_t MAX_PAYLOAD = 65536;
+
+    //! Merge a received segment into the one being built, or start a new one
+    void push(TCPSegment &&seg);
+
+    //! Finish the segment being built, e.g. at the end of a burst
+    void flush();
+
+    //! Coalesced segments, ready for TCPConnection::segment_received()
+    std::queue<TCPSegment> &segments_out() { return _segments_out; }
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_SEGMENT_COALESCER_HH
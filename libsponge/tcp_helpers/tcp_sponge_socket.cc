@@ -5,9 +5,12 @@
 #include "tun.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <exception>
+#include <initializer_list>
 #include <iostream>
+#include <poll.h>
 #include <stdexcept>
 #include <string>
 #include <sys/socket.h>
@@ -18,14 +21,20 @@
 
 using namespace std;
 
-static constexpr size_t TCP_TICK_MS = 10;
+static constexpr size_t TCP_MAX_SLEEP_MS = 1000;  // longest wait without a timer, so an abort is noticed
+static constexpr size_t GRO_MAX_BURST = 64;       // most datagrams read in one go with receive offload
 
 //! \param[in] condition is a function returning true if loop should continue
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
     auto base_time = timestamp_ms();
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        // Sleep until the earliest timer of the connection or the adapter, instead of ticking at a fixed interval.
+        size_t timeout = TCP_MAX_SLEEP_MS;
+        for (const auto &next : {_tcp.value().time_until_next_timer(), _datagram_adapter.time_until_next_timer()}) {
+            timeout = min(timeout, next.value_or(TCP_MAX_SLEEP_MS));
+        }
+        auto ret = _eventloop.wait_next_event(static_cast<int>(timeout));
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
@@ -50,9 +59,19 @@ TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> da
     _thread_data.set_blocking(false);
 }
 
+template <typename AdaptT>
+bool TCPSpongeSocket<AdaptT>::_datagram_ready() {
+    const FileDescriptor &fd = _datagram_adapter;
+    pollfd pfd{fd.fd_num(), POLLIN, 0};
+    return SystemCall("poll", ::poll(&pfd, 1, 0)) > 0 and (pfd.revents & POLLIN);
+}
+
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     _tcp.emplace(config);
+    if (config.receive_offload) {
+        _coalescer.emplace();
+    }
 
     // Set up the event loop
 
@@ -77,7 +96,21 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
                         Direction::In,
                         [&] {
                             auto seg = _datagram_adapter.read();
-                            if (seg) {
+                            if (_coalescer) {
+                                // drain the rest of the burst, merging runs of in-order segments
+                                for (size_t i = 1; seg and i < GRO_MAX_BURST; ++i) {
+                                    _coalescer->push(move(seg.value()));
+                                    seg = _datagram_ready() ? _datagram_adapter.read() : nullopt;
+                                }
+                                if (seg) {
+                                    _coalescer->push(move(seg.value()));
+                                }
+                                _coalescer->flush();
+                                while (not _coalescer->segments_out().empty()) {
+                                    _tcp->segment_received(move(_coalescer->segments_out().front()));
+                                    _coalescer->segments_out().pop();
+                                }
+                            } else if (seg) {
                                 _tcp->segment_received(move(seg.value()));
                             }
 
@@ -128,10 +161,9 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             // Write from the inbound_stream into
             // the pipe, handling the possibility of a partial
             // write (i.e., only pop what was actually written).
-            const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
-            inbound.pop_output(bytes_written);
+            // writev(2) gathers the bytes straight from the stream's
+            // storage, without an intermediate copy.
+            inbound.read_into(_thread_data, min(size_t(65536), inbound.buffer_size()));
 
             if (inbound.eof() or inbound.error()) {
                 _thread_data.shutdown(SHUT_WR);
@@ -8,6 +8,7 @@
 #include "network_interface.hh"
 #include "tcp_config.hh"
 #include "tcp_connection.hh"
+#include "tcp_segment_coalescer.hh"
 #include "tuntap_adapter.hh"
 
 #include <atomic>
@@ -34,6 +35,12 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! TCP state machine
     std::optional<TCPConnection> _tcp{};
 
+    //! Merges the segments of each burst read from the adapter, if receive offload is enabled
+    std::optional<TCPSegmentCoalescer> _coalescer{};
+
+    //! Whether another datagram can be read from the adapter without blocking
+    bool _datagram_ready();
+
     //! eventloop that handles all the events (new inbound datagram, new outbound bytes, new inbound bytes)
     EventLoop _eventloop{};
 
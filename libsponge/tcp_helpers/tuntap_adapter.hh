@@ -27,8 +27,16 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
         return unwrap_tcp_in_ip(ip_dgram);
     }
 
-    //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    //! Creates an IPv4 datagram from each wire segment of a TCP segment and writes it to the TUN device
+    void write(TCPSegment &seg) {
+        if (seg.gso_size() == 0) {
+            _tun.write(wrap_tcp_in_ip(seg).serialize());
+            return;
+        }
+        for (auto &wire_seg : seg.wire_segments()) {
+            _tun.write(wrap_tcp_in_ip(wire_seg).serialize());
+        }
+    }
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
@@ -60,12 +68,15 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
     //! Attempts to read and parse an Ethernet frame containing an IPv4 datagram that contains a TCP segment
     std::optional<TCPSegment> read();
 
-    //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
+    //! Sends a TCP segment (each wire segment in an IPv4 datagram, in an Ethernet frame).
     void write(TCPSegment &seg);
 
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! Milliseconds until the NetworkInterface's next ARP timer, or empty if it has none
+    std::optional<size_t> time_until_next_timer() const { return _interface.time_until_next_timer(); }
+
     //! Access the underlying raw Ethernet connection
     operator TapFD &() { return _tap; }
 
@@ -1,5 +1,7 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+
 // Dummy implementation of a TCP receiver
 
 // For Lab 2, please replace with a real implementation that passes the
@@ -11,7 +13,7 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 using namespace std;
 
 void TCPReceiver::segment_received(const TCPSegment &seg) {
-    TCPHeader header = seg.header();
+    const TCPHeader &header = seg.header();
     WrappingInt32 seqno = header.seqno;
 
     //! If the receiver still in `SYN_RECV` state, refuse any new SYN segment.
@@ -20,6 +22,14 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
         return;
     }
 
+    //! Record the timestamp to echo if the segment starts at or before the left edge of the window.
+    if (header.timestamp.has_value() && (header.syn || (_syn_received && header.seqno - ackno().value() <= 0))) {
+        const uint32_t value = header.timestamp->value;
+        if (!_timestamp_recent.has_value() || static_cast<int32_t>(value - _timestamp_recent.value()) >= 0) {
+            _timestamp_recent = value;
+        }
+    }
+
     //! If the the receiver in `LISTEN` state, get the SYN segment.
     if (!_syn_received && header.syn) {
         _isn = header.seqno;
@@ -34,7 +44,10 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
     //! Use the index of the last reassembled byte as the checkpoint.
     size_t checkpoint = _reassembler.stream_out().bytes_written();
     uint64_t absolute_seqno = unwrap(seqno, _isn, checkpoint);
-    _reassembler.push_substring(seg.payload().copy(), absolute_seqno - 1, header.fin);
+    if (seg.payload().size() > 0) {
+        _latest_index = absolute_seqno - 1;
+    }
+    _reassembler.push_substring(seg.payload(), absolute_seqno - 1, header.fin);
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const {
@@ -48,6 +61,34 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
     return wrap(_reassembler.first_unassembled() + 1 + fin_finished, _isn);
 }
 
+vector<SackBlock> TCPReceiver::sack_blocks(const size_t max_blocks) const {
+    vector<SackBlock> blocks;
+    if (!_syn_received || _reassembler.empty()) {
+        return blocks;
+    }
+
+    //! Stream index `i` is at absolute seqno `i + 1`, after the SYN.
+    const auto ranges = _reassembler.unassembled_ranges();
+    const auto latest = find_if(ranges.begin(), ranges.end(), [this](const auto &range) {
+        return range.first <= _latest_index && _latest_index < range.second;
+    });
+    if (latest != ranges.end() && max_blocks > 0) {
+        blocks.push_back({wrap(latest->first + 1, _isn), wrap(latest->second + 1, _isn)});
+    }
+    for (auto it = ranges.begin(); it != ranges.end() && blocks.size() < max_blocks; ++it) {
+        if (it != latest) {
+            blocks.push_back({wrap(it->first + 1, _isn), wrap(it->second + 1, _isn)});
+        }
+    }
+    return blocks;
+}
+
+//! \param[in] capacity the new maximum number of bytes to store
+void TCPReceiver::set_capacity(const size_t capacity) {
+    _reassembler.set_capacity(capacity);
+    _capacity = _reassembler.capacity();
+}
+
 size_t TCPReceiver::window_size() const {
     //! Equal to `first_unacceptable - first_unassembled`
     return _capacity - _reassembler.stream_out().buffer_size();
@@ -7,6 +7,7 @@
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -33,12 +34,21 @@ class TCPReceiver {
     //! ISN.
     WrappingInt32 _isn;
 
+    //! TS.Recent (RFC 7323): the timestamp to echo to the peer, if it has sent any.
+    std::optional<uint32_t> _timestamp_recent{};
+
+    //! Stream index of the first byte of the most recent segment with a payload,
+    //! so that its SACK block can be reported first.
+    size_t _latest_index = 0;
+
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity) : _reassembler(capacity), _capacity(capacity), _isn(0) {}
+    //! \param storage how the reassembler keeps out-of-order bytes
+    TCPReceiver(const size_t capacity, const StreamReassembler::Storage storage = StreamReassembler::Storage::Segments)
+        : _reassembler(capacity, storage), _capacity(capacity), _isn(0) {}
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -61,11 +71,31 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief The SACK blocks (RFC 2018) that should be sent to the peer
+    //! \param max_blocks is the most blocks to return
+    //!
+    //! One block per run of bytes held beyond the ackno. The block holding the most recently
+    //! received segment comes first, and the rest follow in ascending order.
+    std::vector<SackBlock> sack_blocks(const size_t max_blocks) const;
+
+    //! \brief The timestamp to echo to the peer (TS.Recent, RFC 7323)
+    //! \returns empty until a segment with the timestamps option has been received
+    //!
+    //! It is taken from the newest segment that didn't start beyond the ackno, so that
+    //! the echo reflects the segments that advanced the window rather than later ones.
+    std::optional<uint32_t> timestamp_recent() const { return _timestamp_recent; }
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
 
+    //! \brief The most bytes the receiver stores at once, which bounds the window
+    size_t capacity() const { return _capacity; }
+
+    //! \brief Grow or shrink the receive buffer (e.g. for autotuning), never below what it holds
+    void set_capacity(const size_t capacity);
+
     //! \brief handle an inbound segment
     void segment_received(const TCPSegment &seg);
 
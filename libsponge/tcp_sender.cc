@@ -2,7 +2,11 @@
 
 #include "tcp_config.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <random>
+#include <stdexcept>
 
 // Dummy implementation of a TCP sender
 
@@ -23,17 +27,54 @@ TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const s
     , _stream(capacity)
     , _timer(retx_timeout) {}
 
+//! \param[in] cfg the connection's configuration (capacity, timeout, ISN, MSS and congestion control)
+TCPSender::TCPSender(const TCPConfig &cfg) : TCPSender(cfg.send_capacity, cfg.rt_timeout, cfg.fixed_isn) {
+    //! Segments of no payload would never carry any data (and the MSS divides several sizes).
+    if (cfg.mss == 0) {
+        throw runtime_error("TCPSender: the MSS must be at least one byte");
+    }
+    _mss = cfg.mss;
+    _segmentation_offload = cfg.segmentation_offload;
+    _nagle = cfg.nagle;
+    _corked = cfg.cork;
+    _persist_timer = cfg.persist_timer;
+    _retransmit_collapse = cfg.retransmit_collapse;
+    _max_rto = cfg.max_rto;
+    _congestion_control = cfg.congestion_control;
+    _congestion_controller = make_congestion_controller(_congestion_control, _mss);
+    if (cfg.rtt_estimation) {
+        _rtt_estimator.emplace(cfg.rt_timeout, cfg.min_rto, cfg.max_rto);
+    }
+}
+
+//! \param[in] corked whether to hold back segments that aren't full
+void TCPSender::set_corked(const bool corked) {
+    _corked = corked;
+    _cork_held_ms = 0;
+    if (!corked && _syn_sent) {
+        fill_window();
+    }
+}
+
+//! \param[in] mss the largest payload to put in one segment
+void TCPSender::set_mss(const size_t mss) {
+    if (mss == _mss) {
+        return;
+    }
+    _mss = mss;
+    _congestion_controller = make_congestion_controller(_congestion_control, _mss);
+}
+
 uint64_t TCPSender::bytes_in_flight() const { return _bytes_in_flight; }
 
 void TCPSender::fill_window() {
-    TCPSegment seg;
-
     //! If SYN flag has not sent, sent the SYN segment.
     //! The SYN segment doesn't carry any payload.
     //! The sender's state turn to `SYN_SENT`.
     if (!_syn_sent) {
+        TCPSegment seg;
         seg.header().syn = true;
-        send_segment(seg);
+        send_segment(move(seg));
         _syn_sent = true;
         return;
     }
@@ -43,67 +84,229 @@ void TCPSender::fill_window() {
         return;
     }
 
-    //! Assume the receiver’s window size as one byte
-    //! before sender has gotten an ACK from the receiver
-    //! `zero window probing`
-    uint64_t window_size = _receiver_window_size == 0 ? 1 : _receiver_window_size;
-    uint64_t remain;
-    while ((remain = window_size - (_next_seqno - _last_ackno)) && !_fin_sent) {
+    const uint64_t window_size = _effective_window();
+    while (window_size > _next_seqno - _last_ackno && !_fin_sent && !_pacing_limited()) {
+        const uint64_t remain = window_size - (_next_seqno - _last_ackno);
+        TCPSegment seg;
         //! Set fin flag.
         if (_stream.eof()) {
             seg.header().fin = true;
             _fin_sent = true;
-            send_segment(seg);
+            send_segment(move(seg));
             return;
         }
 
-        uint64_t payload_size = min(remain, TCPConfig::MAX_PAYLOAD_SIZE);
+        uint64_t payload_size = min(remain, _max_payload());
+        //! Nagle's algorithm and corking: send only whole segments of what has been written,
+        //! and leave the rest for when it fills a segment (or no longer needs to wait).
+        if (_stream.buffer_size() < payload_size && _hold_partial_segment()) {
+            payload_size = _stream.buffer_size() / _mss * _mss;
+            if (payload_size == 0 && _stream.buffer_size() > 0) {
+                return;
+            }
+        }
         seg.payload() = _stream.read(payload_size);
         //! After the stream read, check whether the stream eof.
-        if (_stream.eof() && seg.length_in_sequence_space() < window_size) {
+        if (_stream.eof() && seg.length_in_sequence_space() < remain) {
             seg.header().fin = true;
             _fin_sent = true;
         }
-        if (seg.length_in_sequence_space() == 0)
+        //! Out of data with room to spare: until what is in flight now is delivered, rate samples
+        //! measure the application rather than the network.
+        if (seg.length_in_sequence_space() == 0) {
+            _app_limited_until = max(_delivered + _bytes_in_flight, uint64_t{1});
             return;
+        }
 
-        send_segment(seg);
+        send_segment(move(seg));
     }
 }
 
 //! \param ackno The remote receiver's ackno (acknowledgment number)
-//! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+//! \param window_size The remote receiver's advertised window size, in bytes (after any window scaling)
+//! \param pure_ack Whether the ACK came on a segment with no payload, SYN or FIN (only those count as duplicates)
+//! \param sack_blocks The SACK blocks the ACK carried, if the peer agreed to selective acknowledgments
+//! \param timestamp_echo The ACK's echoed timestamp (TSecr), if the peer agreed to the timestamps option
+void TCPSender::ack_received(const WrappingInt32 ackno,
+                             const uint64_t window_size,
+                             const bool pure_ack,
+                             const vector<SackBlock> &sack_blocks,
+                             const optional<uint32_t> timestamp_echo) {
     uint64_t absolute_ackno = unwrap(ackno, _isn, _next_seqno);
     if (!_is_ack_valid(absolute_ackno)) {
         return;
     }
 
+    //! A bare ACK that neither acknowledges new data nor changes the window hints at a lost segment.
+    const bool duplicate =
+        pure_ack && absolute_ackno == _last_ackno && window_size == _receiver_window_size && _bytes_in_flight > 0;
+    //! The SYN's sequence number doesn't count toward congestion window growth.
+    const uint64_t acked_from = max(_last_ackno, uint64_t{1});
+    const uint64_t acked_bytes = absolute_ackno > acked_from ? absolute_ackno - acked_from : 0;
+
     _receiver_window_size = window_size;
-    _last_ackno = absolute_ackno;
+    _last_ackno = max(_last_ackno, absolute_ackno);
 
+    optional<RateSample> sample{};
     while (!_segments_outstanding.empty()) {
-        TCPSegment seg = _segments_outstanding.front();
-        if (unwrap(seg.header().seqno, _isn, _next_seqno) + seg.length_in_sequence_space() > absolute_ackno) {
+        OutstandingSegment &out = _segments_outstanding.front();
+        const TCPSegment &seg = out.segment;
+        const uint64_t seqno = out.seqno;
+        if (seqno + seg.length_in_sequence_space() <= absolute_ackno) {
+            _bytes_in_flight -= seg.length_in_sequence_space();
+            _count(out, seg.length_in_sequence_space(), 1, false);
+            _segment_delivered(out, sample);
+            _segments_outstanding.pop_front();
+        } else if (seqno < absolute_ackno && seg.payload().size() > _mss) {
+            //! A super-segment is acknowledged piece by piece; keep only what is still outstanding.
+            _trim_acknowledged(out, absolute_ackno - seqno);
+        } else {
             break;
         }
-        _bytes_in_flight -= seg.length_in_sequence_space();
-        _segments_outstanding.pop();
 
         _timer.start();
-        _timer.set_rto(_initial_retransmission_timeout);
+        if (!_rtt_estimator) {
+            _timer.set_rto(_initial_retransmission_timeout);
+        }
         _consecutive_retransmissions = 0;
     }
 
+    //! With timestamps, every ACK of new data measures the RTT of the transmission it answers,
+    //! retransmission or not (RFC 7323 RTTM), so Karn's rule is not needed.
+    if (timestamp_echo.has_value() && sample.has_value()) {
+        sample->rtt_ms = static_cast<uint32_t>(timestamp() - timestamp_echo.value());
+    }
+
+    //! Otherwise Karn's rule applies: only segments that were sent once give RTT samples, and
+    //! a backed-off RTO stays until one of them is acknowledged.
+    if (_rtt_estimator && sample.has_value() && sample->rtt_ms.has_value()) {
+        _rtt_estimator->sample(sample->rtt_ms.value());
+        _timer.set_rto(_rtt_estimator->rto());
+    }
+
     if (!bytes_in_flight()) {
         _timer.stop();
     }
+    _loss_scan = max(_loss_scan, _last_ackno);
+    _retransmit_scan = max(_retransmit_scan, _last_ackno);
+
+    //! The window reopened: probing is over. A probe the peer had no room for is sent again at once,
+    //! rather than after a backed-off timeout.
+    if (_persisting && window_size > 0) {
+        _persisting = false;
+        _timer.set_rto(_rtt_estimator ? _rtt_estimator->rto() : _initial_retransmission_timeout);
+        if (acked_bytes == 0 && !_segments_outstanding.empty()) {
+            _retransmit_earliest();
+            _timer.start();
+        }
+    }
+
+    if (_app_limited_until && _delivered > _app_limited_until) {
+        _app_limited_until = 0;
+    }
+
+    if (_congestion_controller && sample.has_value()) {
+        sample->total_delivered = _delivered;
+        sample->delivered = _delivered - sample->prior_delivered;
+        _congestion_controller->on_rate_sample(sample.value());
+    }
+
+    if (!sack_blocks.empty()) {
+        _sack_received(sack_blocks);
+    }
+    const bool scoreboard = _sacked_segments > 0;
+    if (scoreboard) {
+        _mark_lost();
+    }
+
+    //! Fast retransmit: the third duplicate ACK signals a lost segment well before the timer would.
+    //! With congestion control, the controller decides (and may also ask for it on a partial ACK).
+    //! Once the peer SACKs, the scoreboard (or the third duplicate) tells the controller of the loss instead.
+    bool retransmit = false;
+    if (!duplicate) {
+        _dup_acks = 0;
+    }
+    if (acked_bytes > 0) {
+        if (_congestion_controller) {
+            retransmit = _congestion_controller->on_ack(absolute_ackno, acked_bytes, _bytes_in_flight);
+        }
+    } else if (duplicate) {
+        ++_dup_acks;
+        if (!scoreboard) {
+            retransmit = _congestion_controller ? _congestion_controller->on_duplicate_ack(
+                                                      absolute_ackno, _dup_acks, _next_seqno, _bytes_in_flight)
+                                                : _dup_acks == TCPConfig::DUP_ACK_THRESHOLD;
+        }
+    }
+    if (scoreboard && (_segments_outstanding.front().lost || _dup_acks >= TCPConfig::DUP_ACK_THRESHOLD)) {
+        const bool loss = !_congestion_controller ||
+                          _congestion_controller->on_sack_loss(absolute_ackno, _next_seqno, _bytes_in_flight);
+        retransmit = retransmit || loss;
+    }
+    if (retransmit && !_segments_outstanding.empty() && !_segments_outstanding.front().repaired) {
+        _retransmit_earliest();
+        _set_flag(_segments_outstanding.front(), &OutstandingSegment::lost);
+        ++_fast_retransmissions;
+    }
+    if (scoreboard) {
+        _retransmit_lost();
+    }
 
     fill_window();
 }
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) {
+    _time_ms += ms_since_last_tick;
+
+    bool paced = false;
+    if (_congestion_controller) {
+        _congestion_controller->tick(ms_since_last_tick);
+
+        //! Pacing credit accrues with time, but not beyond one tick's worth (or two segments),
+        //! so an idle or window-limited period doesn't turn into a burst later.
+        const double rate = _congestion_controller->pacing_rate();
+        if (rate > 0) {
+            const double credit = rate * ms_since_last_tick;
+            _pacing_credit = min(_pacing_credit + credit, max(credit, 2.0 * _mss));
+            paced = true;
+        }
+    }
+
+    _tick_timer(ms_since_last_tick);
+
+    //! Corked data doesn't wait forever: after CORK_TIMEOUT_MS the partial segment goes out.
+    bool cork_expired = false;
+    if (_corked && _stream.buffer_size() > 0) {
+        _cork_held_ms += ms_since_last_tick;
+        cork_expired = _cork_held_ms >= TCPConfig::CORK_TIMEOUT_MS;
+    }
+
+    if ((paced || cork_expired) && _syn_sent) {
+        fill_window();
+    }
+}
+
+optional<size_t> TCPSender::time_until_next_timer() const {
+    optional<size_t> next{};
+    const auto consider = [&next](const size_t ms) { next = min(next.value_or(ms), ms); };
+
+    if (_timer.is_running() && !_segments_outstanding.empty()) {
+        consider(_timer.time_until_expiry());
+    }
+    //! Once the cork has timed out, the data waits for the window, and only an ACK can open that.
+    if (_corked && _syn_sent && _stream.buffer_size() > 0 && _cork_held_ms < TCPConfig::CORK_TIMEOUT_MS) {
+        consider(TCPConfig::CORK_TIMEOUT_MS - _cork_held_ms);
+    }
+    const bool fin_unsent = _stream.eof() && !_fin_sent;
+    if (_syn_sent && _pacing_limited() && (_stream.buffer_size() > 0 || fin_unsent)) {
+        const double rate = _congestion_controller->pacing_rate();
+        consider(static_cast<size_t>(-_pacing_credit / rate) + 1);
+    }
+    return next;
+}
+
+void TCPSender::_tick_timer(const size_t ms_since_last_tick) {
     //! If the timer not running, skip the tick.
     if (!_timer.is_running()) {
         return;
@@ -114,14 +317,35 @@ void TCPSender::tick(const size_t ms_since_last_tick) {
     //! If the timer is expired and exist outstanding segments,
     //! retransmit the earliest (lowest sequence number) segment
     if (_timer.is_expired() && !_segments_outstanding.empty()) {
-        _segments_out.push(_segments_outstanding.front());
+        _retransmit_earliest();
 
         //! If the window size is nonzero:
         //! 1. keep track of the number of consecutive retransmissions
         //! 2. double the value of RTO
-        if (_receiver_window_size || _segments_outstanding.front().header().syn) {
+        //! 3. tell the congestion controller that a segment was lost
+        if (_receiver_window_size || _segments_outstanding.front().segment.header().syn) {
+            //! After a timeout every hole may be retransmitted again, once the scoreboard deems it lost again.
+            for (auto &out : _segments_outstanding) {
+                out.lost = false;
+                out.repaired = false;
+            }
+            _lost_bytes = 0;
+            _retransmitted_bytes = 0;
+            _loss_scan = _retransmit_scan = _last_ackno;
+            _sacked_below_loss_scan = _sacked_bytes_below_scan = 0;
+            _set_flag(_segments_outstanding.front(), &OutstandingSegment::repaired);
             ++_consecutive_retransmissions;
-            _timer.set_rto(_timer.rto() << 1);
+            ++_timeout_retransmissions;
+            _timer.set_rto(_rtt_estimator ? _rtt_estimator->backoff(_timer.rto()) : _timer.rto() << 1);
+            if (_congestion_controller) {
+                _congestion_controller->on_timeout(_next_seqno, _bytes_in_flight);
+            }
+            _dup_acks = 0;
+        } else if (_persist_timer) {
+            //! An unanswered probe of a zero window: probe less and less often (RFC 9293, 3.8.6.1).
+            //! The peer is alive and answering, just not reading, so this never counts toward giving up.
+            _persisting = true;
+            _timer.set_rto(min(_timer.rto() * 2, _max_rto));
         }
 
         //! reset the transmission timer and start it
@@ -131,19 +355,290 @@ void TCPSender::tick(const size_t ms_since_last_tick) {
 
 unsigned int TCPSender::consecutive_retransmissions() const { return _consecutive_retransmissions; }
 
-void TCPSender::send_segment(TCPSegment &seg) {
+uint64_t TCPSender::congestion_window() const {
+    return _congestion_controller ? _congestion_controller->cwnd() : numeric_limits<uint64_t>::max();
+}
+
+uint64_t TCPSender::slow_start_threshold() const {
+    return _congestion_controller ? _congestion_controller->ssthresh() : numeric_limits<uint64_t>::max();
+}
+
+uint64_t TCPSender::_effective_window() const {
+    //! Assume the receiver’s window size as one byte
+    //! before sender has gotten an ACK from the receiver
+    //! `zero window probing`
+    const uint64_t receiver_window = _receiver_window_size == 0 ? 1 : _receiver_window_size;
+    return min(receiver_window, congestion_window());
+}
+
+void TCPSender::_retransmit_earliest() {
+    if (_segments_outstanding.empty()) {
+        return;
+    }
+    //! Resend one MSS, whatever segments the data was first sent in.
+    if (_retransmit_collapse) {
+        _collapse_earliest();
+    }
+    _split_outstanding_at(_segments_outstanding.front().seqno + _mss);
+    _retransmit(_segments_outstanding.front());
+}
+
+void TCPSender::_retransmit(OutstandingSegment &out) {
+    _stamp_send(out);
+    out.retransmitted = true;
+    _set_flag(out, &OutstandingSegment::repaired);
+    _set_gso_size(out.segment);
+    _segments_out.push(out.segment);
+}
+
+uint64_t TCPSender::_max_payload() const {
+    if (!_segmentation_offload) {
+        return _mss;
+    }
+    uint64_t max_payload = max<uint64_t>(_mss, TCPConfig::GSO_MAX_SIZE / _mss * _mss);
+    //! A paced sender builds super-segments no bigger than its pacing credit (but at least one MSS).
+    if (_congestion_controller && _congestion_controller->pacing_rate() > 0) {
+        const auto credit = static_cast<uint64_t>(max(_pacing_credit, 0.0));
+        max_payload = clamp<uint64_t>(credit / _mss * _mss, _mss, max_payload);
+    }
+    return max_payload;
+}
+
+//! \details Outstanding segments are in sequence order and don't overlap, so their ends are sorted too.
+TCPSender::Outstanding::iterator TCPSender::_outstanding_at(const uint64_t seqno) {
+    return partition_point(_segments_outstanding.begin(), _segments_outstanding.end(), [seqno](const auto &out) {
+        return out.seqno + out.segment.length_in_sequence_space() <= seqno;
+    });
+}
+
+//! \details Only segments with more than one MSS of payload are split: super-segments, which the peer
+//! received (or lost) as separate segments, so SACK blocks and retransmissions may cut into them, and
+//! segments sent before the MSS shrank, which are resent at the MSS now in force.
+void TCPSender::_split_outstanding_at(const uint64_t seqno) {
+    const auto it = _outstanding_at(seqno);
+    if (it == _segments_outstanding.end() || it->seqno >= seqno) {
+        return;
+    }
+    TCPSegment &head = it->segment;
+    const uint64_t head_size = seqno - it->seqno;
+    if (head_size >= head.payload().size() || head.payload().size() <= _mss) {
+        return;
+    }
+
+    OutstandingSegment tail = *it;
+    tail.segment.payload().remove_prefix(head_size);
+    tail.segment.header().seqno = head.header().seqno + head_size;
+    tail.seqno = seqno;
+    head.payload().remove_suffix(head.payload().size() - head_size);
+    head.header().fin = false;
+    _count(tail, 0, 1, true);
+    _segments_outstanding.insert(next(it), move(tail));
+}
+
+//! \details Without Nagle's algorithm, small writes go out as small segments; rather than resend them one
+//! by one as they were first sent, they are merged (as in Linux's retransmit collapsing) up to one MSS, as
+//! far as the receiver's window reaches. SACKed segments, the SYN and whatever follows a FIN stay apart.
+void TCPSender::_collapse_earliest() {
+    OutstandingSegment &first = _segments_outstanding.front();
+    const TCPHeader &header = first.segment.header();
+    if (header.syn || header.fin || first.sacked) {
+        return;
+    }
+    const uint64_t window_end = _last_ackno + _receiver_window_size;
+    string payload{};
+    bool fin = false;
+    auto last = next(_segments_outstanding.begin());
+    for (; last != _segments_outstanding.end() && !fin; ++last) {
+        const TCPSegment &seg = last->segment;
+        if (last->sacked || seg.header().syn ||
+            first.segment.payload().size() + payload.size() + seg.payload().size() > _mss ||
+            last->seqno + seg.length_in_sequence_space() > window_end) {
+            break;
+        }
+        payload.append(seg.payload().str());
+        fin = seg.header().fin;
+    }
+    if (payload.empty() && !fin) {
+        return;
+    }
+    for (auto it = _segments_outstanding.begin(); it != last; ++it) {
+        _count(*it, it->segment.length_in_sequence_space(), 1, false);
+    }
+    first.segment.payload() = first.segment.payload().copy() + payload;
+    first.segment.header().fin = fin;
+    _count(first, first.segment.length_in_sequence_space(), 1, true);
+    _segments_outstanding.erase(next(_segments_outstanding.begin()), last);
+}
+
+void TCPSender::_trim_acknowledged(OutstandingSegment &out, const uint64_t n) {
+    _count(out, n, 0, false);
+    out.segment.payload().remove_prefix(n);
+    out.segment.header().seqno = out.segment.header().seqno + n;
+    out.seqno += n;
+    _bytes_in_flight -= n;
+    _delivered += n;
+    _delivered_ms = _time_ms;
+}
+
+void TCPSender::_set_gso_size(TCPSegment &seg) const { seg.set_gso_size(seg.payload().size() > _mss ? _mss : 0); }
+
+//! \details Once the stream has ended nothing is held back, so the last of the data goes out with the FIN.
+bool TCPSender::_hold_partial_segment() const {
+    if (_stream.input_ended()) {
+        return false;
+    }
+    if (_corked) {
+        return _cork_held_ms < TCPConfig::CORK_TIMEOUT_MS;
+    }
+    return _nagle && _bytes_in_flight > 0;
+}
+
+void TCPSender::_sack_received(const vector<SackBlock> &sack_blocks) {
+    for (const SackBlock &block : sack_blocks) {
+        const uint64_t begin = unwrap(block.begin, _isn, _next_seqno);
+        const uint64_t end = unwrap(block.end, _isn, _next_seqno);
+        //! Ignore blocks that are empty, already cumulatively acknowledged, or beyond what was sent.
+        if (begin >= end || begin < _last_ackno || end > _next_seqno) {
+            continue;
+        }
+        _split_outstanding_at(begin);
+        _split_outstanding_at(end);
+        for (auto it = _outstanding_at(begin); it != _segments_outstanding.end() && it->seqno < end; ++it) {
+            if (!it->sacked && it->seqno >= begin && it->seqno + it->segment.length_in_sequence_space() <= end) {
+                _set_flag(*it, &OutstandingSegment::sacked);
+            }
+        }
+    }
+}
+
+//! \param[in] out the outstanding segment, whose flags say which totals it counts in
+//! \param[in] bytes how many of its sequence numbers to add or take away
+//! \param[in] segments 1 if the segment itself is added or taken away, 0 if only some of its bytes are
+//! \param[in] add whether to add them (or take them away)
+void TCPSender::_count(const OutstandingSegment &out, const uint64_t bytes, const uint64_t segments, const bool add) {
+    const auto update = [add](uint64_t &total, const uint64_t n) { total = add ? total + n : total - n; };
+    if (out.sacked) {
+        update(_sacked_segments, segments);
+        update(_sacked_bytes, bytes);
+        if (out.seqno < _loss_scan) {
+            update(_sacked_below_loss_scan, segments);
+            update(_sacked_bytes_below_scan, bytes);
+        }
+        return;
+    }
+    if (out.lost) {
+        update(_lost_bytes, bytes);
+    }
+    if (out.repaired) {
+        update(_retransmitted_bytes, bytes);
+    }
+}
+
+void TCPSender::_set_flag(OutstandingSegment &out, bool OutstandingSegment::*const flag) {
+    const uint64_t length = out.segment.length_in_sequence_space();
+    _count(out, length, 1, false);
+    out.*flag = true;
+    _count(out, length, 1, true);
+}
+
+//! \details As in RFC 6675: once DUP_ACK_THRESHOLD segments, or more than (DUP_ACK_THRESHOLD - 1)
+//! segments' worth of bytes, above it have been SACKed.
+bool TCPSender::_sacked_enough(const uint64_t sacked_segments, const uint64_t sacked_bytes) const {
+    return sacked_segments >= TCPConfig::DUP_ACK_THRESHOLD || sacked_bytes > (TCPConfig::DUP_ACK_THRESHOLD - 1) * _mss;
+}
+
+//! \details What is SACKed above a segment only shrinks going up, so the lost segments all lie below
+//! the first one that isn't lost; the scan resumes there, rather than at the lowest segment.
+void TCPSender::_mark_lost() {
+    for (auto it = _outstanding_at(_loss_scan); it != _segments_outstanding.end(); ++it) {
+        if (it->sacked) {
+            ++_sacked_below_loss_scan;
+            _sacked_bytes_below_scan += it->segment.length_in_sequence_space();
+        } else if (!_sacked_enough(_sacked_segments - _sacked_below_loss_scan,
+                                   _sacked_bytes - _sacked_bytes_below_scan)) {
+            return;
+        } else if (!it->lost) {
+            _set_flag(*it, &OutstandingSegment::lost);
+        }
+        _loss_scan = it->seqno + it->segment.length_in_sequence_space();
+    }
+}
+
+//! \details RFC 6675's NextSeg() and the loop around it (section 5, step C): the scan resumes after the
+//! last segment retransmitted, and stops when the pipe fills the window, to go on at a later ACK.
+void TCPSender::_retransmit_lost() {
+    for (auto it = _outstanding_at(_retransmit_scan); it != _segments_outstanding.end() && it->seqno < _loss_scan;
+         ++it) {
+        if (it->lost && !it->sacked && !it->repaired) {
+            if (_pipe() >= _effective_window()) {
+                return;
+            }
+            _retransmit(*it);
+            ++_fast_retransmissions;
+        }
+        _retransmit_scan = it->seqno + it->segment.length_in_sequence_space();
+    }
+}
+
+//! \details Counted as Linux does: what is in flight, less what was SACKed or deemed lost, plus what
+//! was retransmitted.
+uint64_t TCPSender::_pipe() const { return _bytes_in_flight + _retransmitted_bytes - _sacked_bytes - _lost_bytes; }
+
+void TCPSender::_stamp_send(OutstandingSegment &out) {
+    //! A send into an empty network starts a new sampling interval.
+    if (_bytes_in_flight == 0) {
+        _first_sent_ms = _time_ms;
+        _delivered_ms = _time_ms;
+    }
+    out.sent_ms = _time_ms;
+    out.first_sent_ms = _first_sent_ms;
+    out.delivered = _delivered;
+    out.delivered_ms = _delivered_ms;
+    out.app_limited = _app_limited_until != 0;
+}
+
+bool TCPSender::_pacing_limited() const {
+    return _congestion_controller && _congestion_controller->pacing_rate() > 0 && _pacing_credit <= 0;
+}
+
+//! \details Segments are acknowledged in the order they were sent, so the last one
+//! acknowledged by an ACK is the newest, and the sample is taken from it: the
+//! bytes delivered since it was sent, over the longer of the time it took to send
+//! them and the time it took for them to be acknowledged.
+void TCPSender::_segment_delivered(const OutstandingSegment &out, optional<RateSample> &sample) {
+    _delivered += out.segment.length_in_sequence_space();
+    _delivered_ms = _time_ms;
+
+    RateSample &newest = sample.has_value() ? sample.value() : sample.emplace();
+    newest.prior_delivered = out.delivered;
+    newest.interval_ms = max(out.sent_ms - out.first_sent_ms, _delivered_ms - out.delivered_ms);
+    newest.rtt_ms = out.retransmitted ? nullopt : optional<uint64_t>{_time_ms - out.sent_ms};
+    newest.app_limited = out.app_limited;
+    _first_sent_ms = out.sent_ms;
+}
+
+void TCPSender::send_segment(TCPSegment &&seg) {
     seg.header().seqno = next_seqno();
+    const size_t length = seg.length_in_sequence_space();
 
     //! If the timer is not running, start the timer.
     if (!_timer.is_running()) {
         _timer.start();
     }
 
+    if (_congestion_controller && _congestion_controller->pacing_rate() > 0) {
+        _pacing_credit -= static_cast<double>(length);
+    }
+
+    _set_gso_size(seg);
+    _cork_held_ms = 0;
+    //! The one copy: the queued segment goes out to the network, the outstanding one stays behind.
     _segments_out.push(seg);
-    _segments_outstanding.push(seg);
+    _segments_outstanding.push_back({move(seg), _next_seqno, 0, 0, 0, 0, false});
+    _stamp_send(_segments_outstanding.back());
 
-    _next_seqno += seg.length_in_sequence_space();
-    _bytes_in_flight += seg.length_in_sequence_space();
+    _next_seqno += length;
+    _bytes_in_flight += length;
 
     //! If the timer is not running, start the timer.
     if (!_timer.is_running()) {
@@ -154,7 +649,7 @@ void TCPSender::send_segment(TCPSegment &seg) {
 void TCPSender::send_empty_segment() {
     TCPSegment seg;
     seg.header().seqno = next_seqno();
-    _segments_out.push(seg);
+    _segments_out.push(move(seg));
 }
 
 bool TCPSender::_is_ack_valid(uint64_t absolute_ackno) const {
@@ -162,6 +657,36 @@ bool TCPSender::_is_ack_valid(uint64_t absolute_ackno) const {
     return absolute_ackno <= _next_seqno;
 }
 
+//! \param[in] initial_rto the RTO until the first RTT sample, in milliseconds
+//! \param[in] min_rto the lower bound on the RTO, in milliseconds
+//! \param[in] max_rto the upper bound on the RTO, in milliseconds
+RTTEstimator::RTTEstimator(const unsigned int initial_rto, const unsigned int min_rto, const unsigned int max_rto)
+    : _initial_rto(initial_rto), _min_rto(min_rto), _max_rto(max_rto) {}
+
+//! \param[in] rtt_ms the time from sending a segment to its acknowledgment, in milliseconds
+void RTTEstimator::sample(const uint64_t rtt_ms) {
+    const double rtt = rtt_ms;
+    if (!_srtt.has_value()) {
+        _srtt = rtt;
+        _rttvar = rtt / 2;
+        return;
+    }
+    //! RTTVAR is updated first, with the previous SRTT.
+    _rttvar = (1 - BETA) * _rttvar + BETA * abs(_srtt.value() - rtt);
+    _srtt = (1 - ALPHA) * _srtt.value() + ALPHA * rtt;
+}
+
+unsigned int RTTEstimator::rto() const {
+    if (!_srtt.has_value()) {
+        return _initial_rto;
+    }
+    const double rto = ceil(_srtt.value() + max(CLOCK_GRANULARITY_MS, 4 * _rttvar));
+    return clamp(static_cast<unsigned int>(rto), _min_rto, _max_rto);
+}
+
+//! \param[in] rto the RTO that just expired, in milliseconds
+unsigned int RTTEstimator::backoff(const unsigned int rto) const { return min(rto << 1, _max_rto); }
+
 Timer::Timer(const unsigned int _initial_retransmission_timeout)
     : _retransmission_timeout(_initial_retransmission_timeout) {}
 
@@ -176,6 +701,10 @@ bool Timer::is_running() const { return this->_is_timer_running; }
 
 bool Timer::is_expired() const { return this->_time_elapsed >= this->_retransmission_timeout; }
 
+unsigned int Timer::time_until_expiry() const {
+    return is_expired() ? 0 : this->_retransmission_timeout - this->_time_elapsed;
+}
+
 void Timer::tick(const size_t ms_since_last_tick) { this->_time_elapsed = this->_time_elapsed + ms_since_last_tick; }
 
 unsigned int Timer::rto() const { return this->_retransmission_timeout; }
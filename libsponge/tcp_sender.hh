@@ -2,12 +2,17 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_controller.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <deque>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <queue>
+#include <vector>
 
 //! \brief The retransmission timer.
 class Timer {
@@ -37,6 +42,9 @@ class Timer {
     //! Whether the timer expired
     bool is_expired() const;
 
+    //! Milliseconds until the timer expires (zero once it has)
+    unsigned int time_until_expiry() const;
+
     //! \brief Notifies the Timer of the passage of time
     void tick(const size_t ms_since_last_tick);
 
@@ -47,6 +55,46 @@ class Timer {
     void set_rto(const unsigned int _rto);
 };
 
+//! \brief Round-trip time estimation, and the retransmission timeout it gives ([RFC 6298](\ref rfc::rfc6298)).
+class RTTEstimator {
+  private:
+    //! Smoothed RTT, in milliseconds
+    std::optional<double> _srtt{};
+
+    //! RTT variation, in milliseconds
+    double _rttvar{0};
+
+    //! RTO before the first sample
+    unsigned int _initial_rto;
+
+    //! Bounds on the RTO
+    unsigned int _min_rto;
+    unsigned int _max_rto;
+
+  public:
+    //! Initialize with the RTO to use until the first sample, and the bounds on the RTO
+    RTTEstimator(const unsigned int initial_rto, const unsigned int min_rto, const unsigned int max_rto);
+
+    //! \brief Take a new RTT measurement, from a segment that was not retransmitted (Karn's rule)
+    void sample(const uint64_t rtt_ms);
+
+    //! Smoothed RTT (SRTT), in milliseconds, if any RTT has been measured
+    std::optional<double> srtt() const { return _srtt; }
+
+    //! RTT variation (RTTVAR), in milliseconds
+    double rttvar() const { return _rttvar; }
+
+    //! RTO = SRTT + max(G, 4 * RTTVAR), within the bounds (the initial RTO before any sample)
+    unsigned int rto() const;
+
+    //! Double `rto` after a timeout, up to the maximum
+    unsigned int backoff(const unsigned int rto) const;
+
+    static constexpr double ALPHA = 1.0 / 8;           //!< Gain of SRTT
+    static constexpr double BETA = 1.0 / 4;            //!< Gain of RTTVAR
+    static constexpr double CLOCK_GRANULARITY_MS = 1;  //!< G: the sender's clock ticks in milliseconds
+};
+
 //! \brief The "sender" part of a TCP implementation.
 
 //! Accepts a ByteStream, divides it up into segments and sends the
@@ -55,6 +103,21 @@ class Timer {
 //! segments if the retransmission timer expires.
 class TCPSender {
   private:
+    //! \brief A segment sent but not yet acknowledged, with the state to sample the delivery rate when it is
+    struct OutstandingSegment {
+        TCPSegment segment;
+        uint64_t seqno;             //!< Absolute sequence number of its first byte
+        uint64_t sent_ms;           //!< When the segment was (last) sent
+        uint64_t first_sent_ms;     //!< When the first segment of its sampling interval was sent
+        uint64_t delivered;         //!< Bytes delivered when it was sent
+        uint64_t delivered_ms;      //!< When those bytes had been delivered
+        bool app_limited;           //!< Whether it was sent while the sender was application-limited
+        bool retransmitted{false};  //!< Whether it was retransmitted (so its ACK gives no RTT sample)
+        bool sacked{false};         //!< Whether the receiver has selectively acknowledged it
+        bool lost{false};           //!< Whether the scoreboard deemed it lost since the last timeout
+        bool repaired{false};       //!< Whether it was retransmitted since the last timeout
+    };
+
     //! our initial sequence number, the number for our SYN.
     WrappingInt32 _isn;
 
@@ -67,6 +130,29 @@ class TCPSender {
     //! outgoing stream of bytes that have not yet been sent
     ByteStream _stream;
 
+    //! the largest payload to put in one segment on the wire
+    size_t _mss{TCPConfig::MAX_PAYLOAD_SIZE};
+
+    //! whether to send super-segments of many MSS, for the adapter to split (segmentation offload)
+    bool _segmentation_offload{false};
+
+    //! whether to merge small outstanding segments into one MSS when retransmitting
+    bool _retransmit_collapse{false};
+
+    //! \name Nagle's algorithm and corking
+    //!@{
+    bool _nagle{false};       //!< Hold back a partial segment while data is unacknowledged
+    bool _corked{false};      //!< Hold back partial segments whether or not data is unacknowledged
+    size_t _cork_held_ms{0};  //!< How long data has waited since the last segment went out while corked
+    //!@}
+
+    //! \name Zero-window probing (the persist timer)
+    //!@{
+    bool _persist_timer{false};                      //!< Back off probes of a zero window
+    unsigned int _max_rto{TCPConfig::MAX_RTO_DFLT};  //!< Longest interval between probes
+    bool _persisting{false};                         //!< Whether a probe has gone unanswered
+    //!@}
+
     //! the (absolute) sequence number for the next byte to be sent
     uint64_t _next_seqno{0};
 
@@ -76,14 +162,15 @@ class TCPSender {
     //! the number of consecutive retransmissions
     unsigned int _consecutive_retransmissions{0};
 
-    //! the size of receiver window.
-    uint16_t _receiver_window_size{0};
+    //! the size of receiver window, in bytes (already scaled by the peer's window scale).
+    uint64_t _receiver_window_size{0};
 
     //! the tcp sender timer
     Timer _timer;
 
-    //! outstanding segments that the TCPSender may resend
-    std::queue<TCPSegment> _segments_outstanding{};
+    //! outstanding segments that the TCPSender may resend, in sequence order (the SACK scoreboard)
+    using Outstanding = std::deque<OutstandingSegment>;
+    Outstanding _segments_outstanding{};
 
     //! Whether the SYN flag sent
     //! If SYN sent, the sender's state convert `CLOSED` to `SYN_SENT`
@@ -95,12 +182,122 @@ class TCPSender {
     //! How many sequence numbers are occupied by segments sent but not yet acknowledged.
     uint64_t _bytes_in_flight = 0;
 
+    //! RTT estimator setting the RTO, or empty to keep the initial RTO
+    std::optional<RTTEstimator> _rtt_estimator{};
+
+    //! congestion control algorithm, and the policy implementing it (nullptr to be limited by the receiver's window)
+    TCPConfig::CongestionControl _congestion_control{TCPConfig::CongestionControl::None};
+    std::unique_ptr<CongestionController> _congestion_controller{};
+
+    //! the number of duplicate ACKs received in a row
+    unsigned int _dup_acks{0};
+
+    //! \name SACK scoreboard totals
+    //! Kept up to date as segments are SACKed, deemed lost, retransmitted and acknowledged, so an ACK
+    //! only touches the segments it changes. SACKed segments count only as SACKed.
+    //!@{
+    uint64_t _sacked_segments{0};          //!< Outstanding segments SACKed
+    uint64_t _sacked_bytes{0};             //!< Sequence numbers they hold
+    uint64_t _lost_bytes{0};               //!< Sequence numbers held by segments deemed lost
+    uint64_t _retransmitted_bytes{0};      //!< Sequence numbers held by segments retransmitted since the last timeout
+    uint64_t _loss_scan{0};                //!< Below this, every segment is SACKed or deemed lost
+    uint64_t _sacked_below_loss_scan{0};   //!< SACKed segments below `_loss_scan`
+    uint64_t _sacked_bytes_below_scan{0};  //!< Sequence numbers they hold
+    uint64_t _retransmit_scan{0};          //!< Below this, every segment deemed lost was retransmitted
+    //!@}
+
+    //! the number of segments retransmitted on duplicate ACKs (or partial ACKs in fast recovery)
+    uint64_t _fast_retransmissions{0};
+
+    //! the number of segments retransmitted because the retransmission timer expired
+    uint64_t _timeout_retransmissions{0};
+
+    //! milliseconds elapsed since the sender was created
+    uint64_t _time_ms{0};
+
+    //! \name Delivery-rate sampling
+    //!@{
+    uint64_t _delivered{0};          //!< Bytes acknowledged so far
+    uint64_t _delivered_ms{0};       //!< When `_delivered` last grew
+    uint64_t _first_sent_ms{0};      //!< When the newest acknowledged segment was sent
+    uint64_t _app_limited_until{0};  //!< If nonzero, the sender is application-limited until `_delivered` passes it
+    //!@}
+
+    //! bytes the pacing rate still allows to be sent before the next tick (negative when overdrawn)
+    double _pacing_credit{0};
+
+    //! The number of sequence numbers the sender may have in flight: min(cwnd, rwnd)
+    uint64_t _effective_window() const;
+
+    //! Retransmit the earliest (lowest sequence number) outstanding segment, or its first MSS
+    void _retransmit_earliest();
+
+    //! The most payload to put in the next segment
+    uint64_t _max_payload() const;
+
+    //! The first outstanding segment that ends after `seqno` (the one holding `seqno`, if any), by binary search
+    Outstanding::iterator _outstanding_at(const uint64_t seqno);
+
+    //! Split the outstanding super-segment (if any) with `seqno` inside its payload, so `seqno` starts a segment
+    void _split_outstanding_at(const uint64_t seqno);
+
+    //! Merge the small outstanding segments that follow the first into it, up to one MSS
+    void _collapse_earliest();
+
+    //! Drop the first `n` sequence numbers of a partly acknowledged outstanding segment
+    void _trim_acknowledged(OutstandingSegment &out, const uint64_t n);
+
+    //! Set the GSO size of a segment about to be (re)sent: the MSS, if its payload needs splitting
+    void _set_gso_size(TCPSegment &seg) const;
+
+    //! Whether Nagle's algorithm or corking holds back data that doesn't fill a segment
+    bool _hold_partial_segment() const;
+
+    //! Retransmit an outstanding segment, marking it as repaired
+    void _retransmit(OutstandingSegment &out);
+
+    //! Advance the retransmission timer, and retransmit if it expires
+    void _tick_timer(const size_t ms_since_last_tick);
+
+    //! Record in `out` the delivery state at the moment it is (re)sent
+    void _stamp_send(OutstandingSegment &out);
+
+    //! Whether the pacing rate holds back the next segment until a later tick
+    bool _pacing_limited() const;
+
+    //! Account for an outstanding segment just acknowledged, taking `sample` from it if it is the newest
+    void _segment_delivered(const OutstandingSegment &out, std::optional<RateSample> &sample);
+
+    //! Mark the outstanding segments covered by SACK blocks as SACKed
+    void _sack_received(const std::vector<SackBlock> &sack_blocks);
+
+    //! Add (or take away) `bytes` and `segments` of an outstanding segment to the scoreboard totals
+    void _count(const OutstandingSegment &out, const uint64_t bytes, const uint64_t segments, const bool add);
+
+    //! Set one of the flags of an outstanding segment, keeping the scoreboard totals
+    void _set_flag(OutstandingSegment &out, bool OutstandingSegment::*const flag);
+
+    //! Whether enough has been SACKed above a segment for it to be deemed lost
+    bool _sacked_enough(const uint64_t sacked_segments, const uint64_t sacked_bytes) const;
+
+    //! Mark the segments that the SACKs received so far show to be lost
+    void _mark_lost();
+
+    //! Retransmit the segments deemed lost, lowest first, while the pipe stays under the window
+    void _retransmit_lost();
+
+    //! RFC 6675's pipe: the sender's estimate of the sequence numbers still in the network
+    uint64_t _pipe() const;
+
   public:
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
               const std::optional<WrappingInt32> fixed_isn = {});
 
+    //! Initialize a TCPSender from a connection's configuration, including its congestion control
+    explicit TCPSender(const TCPConfig &cfg);
+
     //! \name "Input" interface for the writer
     //!@{
     ByteStream &stream_in() { return _stream; }
@@ -111,7 +308,11 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    void ack_received(const WrappingInt32 ackno,
+                      const uint64_t window_size,
+                      const bool pure_ack = true,
+                      const std::vector<SackBlock> &sack_blocks = {},
+                      const std::optional<uint32_t> timestamp_echo = {});
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -119,8 +320,19 @@ class TCPSender {
     //! \brief create and send segments to fill as much of the window as possible
     void fill_window();
 
+    //! \brief Cork or uncork the sender; uncorking sends any partial segment held back
+    void set_corked(const bool corked);
+
+    //! \brief Set the largest payload per segment, e.g. once the peer's SYN gives its MSS
+    //! \note Meant to be called before any data is sent: the congestion controller starts over with the new MSS.
+    void set_mss(const size_t mss);
+
     //! \brief Notifies the TCPSender of the passage of time
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief Milliseconds until a tick has something to do (retransmit, uncork, or send on pacing credit),
+    //! or empty if nothing will happen until a segment arrives or the application acts
+    std::optional<size_t> time_until_next_timer() const;
     //!@}
 
     //! \name Accessors
@@ -134,6 +346,33 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief Largest payload per segment, in bytes
+    size_t mss() const { return _mss; }
+
+    //! \brief Congestion window, in bytes (unbounded without congestion control)
+    uint64_t congestion_window() const;
+
+    //! \brief Sequence numbers the sender may have in flight: the smaller of the congestion and receive windows
+    uint64_t send_window() const { return _effective_window(); }
+
+    //! \brief Slow-start threshold, in bytes (unbounded without congestion control)
+    uint64_t slow_start_threshold() const;
+
+    //! \brief Round-trip time estimate (empty unless RTT estimation is enabled)
+    const std::optional<RTTEstimator> &rtt_estimator() const { return _rtt_estimator; }
+
+    //! \brief Number of segments retransmitted on duplicate ACKs, rather than after a timeout
+    uint64_t fast_retransmissions() const { return _fast_retransmissions; }
+
+    //! \brief Number of segments retransmitted after the retransmission timer expired (window probes excluded)
+    uint64_t timeout_retransmissions() const { return _timeout_retransmissions; }
+
+    //! \brief The timestamp clock (TSval, RFC 7323) to put on outgoing segments, in milliseconds
+    uint32_t timestamp() const { return static_cast<uint32_t>(_time_ms); }
+
+    //! \brief Current retransmission timeout, in milliseconds
+    unsigned int retransmission_timeout() const { return _timer.rto(); }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
@@ -151,8 +390,9 @@ class TCPSender {
     WrappingInt32 next_seqno() const { return wrap(_next_seqno, _isn); }
     //!@}
 
-    //! Send segment
-    void send_segment(TCPSegment &seg);
+    //! \brief Send a segment, keeping it outstanding until it is acknowledged
+    //! \details It is copied once, into segments_out(); the copy shares its payload.
+    void send_segment(TCPSegment &&seg);
 
     //! Whether the ack valid
     bool _is_ack_valid(uint64_t absolute_ackno) const;
@@ -0,0 +1,61 @@
+#include "memory_budget.hh"
+
+#include <utility>
+
+using namespace std;
+
+//! \details Racing connections may each see room for their own charge; the compare-and-swap makes
+//! sure the ones that win never take the total past the threshold together.
+bool MemoryBudget::try_charge(const size_t bytes) {
+    size_t allocated = _allocated.load();
+    do {
+        if (allocated + bytes > _pressure) {
+            return false;
+        }
+    } while (not _allocated.compare_exchange_weak(allocated, allocated + bytes));
+    return true;
+}
+
+MemoryBudget::Reservation::Reservation(shared_ptr<MemoryBudget> budget, const size_t bytes)
+    : _budget(move(budget)), _bytes(bytes) {
+    if (_budget) {
+        _budget->charge(_bytes);
+    }
+}
+
+//! \param[in] bytes the size the reservation should have; shrinking always succeeds
+bool MemoryBudget::Reservation::resize(const size_t bytes) {
+    if (_budget) {
+        if (bytes > _bytes and not _budget->try_charge(bytes - _bytes)) {
+            return false;
+        }
+        if (bytes < _bytes) {
+            _budget->release(_bytes - bytes);
+        }
+    }
+    _bytes = bytes;
+    return true;
+}
+
+MemoryBudget::Reservation::~Reservation() {
+    if (_budget) {
+        _budget->release(_bytes);
+    }
+}
+
+MemoryBudget::Reservation::Reservation(Reservation &&other) noexcept
+    : _budget(move(other._budget)), _bytes(other._bytes) {
+    other._bytes = 0;
+}
+
+MemoryBudget::Reservation &MemoryBudget::Reservation::operator=(Reservation &&other) noexcept {
+    if (this != &other) {
+        if (_budget) {
+            _budget->release(_bytes);
+        }
+        _budget = move(other._budget);
+        _bytes = other._bytes;
+        other._bytes = 0;
+    }
+    return *this;
+}
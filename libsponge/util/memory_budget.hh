@@ -0,0 +1,77 @@
+#ifndef SPONGE_LIBSPONGE_MEMORY_BUDGET_HH
+#define SPONGE_LIBSPONGE_MEMORY_BUDGET_HH
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+//! \brief Buffer memory shared by many connections, like Linux's `tcp_mem`
+//! \details Each connection charges the capacity of its buffers to the budget. Buffers only grow
+//! while the total stays within the pressure threshold; under pressure, grown buffers shrink back
+//! to their configured size, and past the limit every buffer shrinks to what it holds (closing the
+//! receive window) until memory is freed. A budget may be shared between threads.
+class MemoryBudget {
+  private:
+    const size_t _limit;                //!< Past this, buffers shrink to what they hold
+    const size_t _pressure;             //!< Past this, buffers neither grow nor stay grown
+    std::atomic<size_t> _allocated{0};  //!< Bytes charged by all connections
+
+  public:
+    //! Construct a budget of `limit` bytes, under pressure past `pressure` bytes
+    MemoryBudget(const size_t limit, const size_t pressure) : _limit(limit), _pressure(pressure) {}
+
+    //! Construct a budget of `limit` bytes, under pressure past three quarters of it
+    explicit MemoryBudget(const size_t limit) : MemoryBudget(limit, limit / 4 * 3) {}
+
+    size_t limit() const { return _limit; }                  //!< Bytes past which buffers shrink to their contents
+    size_t pressure_threshold() const { return _pressure; }  //!< Bytes past which grown buffers shrink
+    size_t allocated() const { return _allocated.load(); }   //!< Bytes charged by all connections
+
+    //! Whether buffers should stop growing, and shrink back to their configured sizes
+    bool under_pressure() const { return allocated() > _pressure; }
+
+    //! Whether buffers should shrink to what they hold
+    bool exhausted() const { return allocated() > _limit; }
+
+    //! \brief Charge `bytes`, if the total stays within the pressure threshold
+    //! \returns whether they were charged
+    bool try_charge(const size_t bytes);
+
+    //! Charge `bytes`, however far past the limit that takes the total
+    void charge(const size_t bytes) { _allocated += bytes; }
+
+    //! Give back `bytes` charged earlier
+    void release(const size_t bytes) { _allocated -= bytes; }
+
+    //! \brief One connection's share of a budget, given back when it is destroyed
+    //! \details Without a budget, it only keeps count and can grow without bound.
+    class Reservation {
+      private:
+        std::shared_ptr<MemoryBudget> _budget;
+        size_t _bytes;
+
+      public:
+        //! Reserve `bytes` of `budget` (if there is one), even past its limit
+        Reservation(std::shared_ptr<MemoryBudget> budget, const size_t bytes);
+
+        //! \brief Shrink the reservation to `bytes`, or grow it if the budget allows
+        //! \returns whether it now holds `bytes`
+        bool resize(const size_t bytes);
+
+        //! Bytes reserved
+        size_t bytes() const { return _bytes; }
+
+        //! \name construction and destruction
+        //! moving is allowed; copying is disallowed
+
+        //!@{
+        ~Reservation();  //!< gives the reserved bytes back
+        Reservation(Reservation &&other) noexcept;
+        Reservation &operator=(Reservation &&other) noexcept;
+        Reservation(const Reservation &other) = delete;
+        Reservation &operator=(const Reservation &other) = delete;
+        //!@}
+    };
+};
+
+#endif  // SPONGE_LIBSPONGE_MEMORY_BUDGET_HH
@@ -0,0 +1,138 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+bool TimerWheel::_current(const SlotEntry &entry) const {
+    const auto it = _timers.find(entry.first);
+    return it != _timers.end() and it->second.arming == entry.second;
+}
+
+//! \details A deadline goes in the lowest level `k` whose digits above `k` (in base SLOTS) match the
+//! clock's, in the slot given by its digit `k`. That slot is ahead of the clock's digit `k`, so it is
+//! reached exactly when the lower digits of the clock are all zero, which is when it is cascaded.
+void TimerWheel::_place(const SlotEntry &entry, const uint64_t deadline) {
+    for (size_t level = 0; level < LEVELS; level++) {
+        const unsigned shift = SLOT_BITS * level;
+        if ((deadline >> (shift + SLOT_BITS)) == (_now >> (shift + SLOT_BITS))) {
+            _slots[level][(deadline >> shift) & (SLOTS - 1)].push_back(entry);
+            _level_entries[level]++;
+            return;
+        }
+    }
+    _overflow.push_back(entry);
+}
+
+void TimerWheel::_cascade(vector<SlotEntry> &slot) {
+    vector<SlotEntry> entries{};
+    swap(entries, slot);
+    for (const auto &entry : entries) {
+        if (_current(entry)) {
+            _place(entry, _timers.at(entry.first).deadline);
+        }
+    }
+}
+
+void TimerWheel::_step(vector<Key> &expired) {
+    _now++;
+
+    //! When the clock's lower digits roll over to zero, the slots the clock just reached in the
+    //! levels above are emptied into the levels below, from the top down.
+    size_t top = 0;
+    while (top + 1 < LEVELS and ((_now >> (SLOT_BITS * (top + 1))) << (SLOT_BITS * (top + 1))) == _now) {
+        top++;
+    }
+    if (top + 1 == LEVELS and (_now & ((uint64_t{1} << (SLOT_BITS * LEVELS)) - 1)) == 0) {
+        _cascade(_overflow);
+    }
+    for (size_t level = top; level > 0; level--) {
+        auto &slot = _slots[level][(_now >> (SLOT_BITS * level)) & (SLOTS - 1)];
+        _level_entries[level] -= slot.size();
+        _cascade(slot);
+    }
+
+    auto &slot = _slots[0][_now & (SLOTS - 1)];
+    _level_entries[0] -= slot.size();
+    for (const auto &entry : slot) {
+        if (_current(entry)) {
+            expired.push_back(entry.first);
+            _timers.erase(entry.first);
+        }
+    }
+    slot.clear();
+}
+
+//! \param[in] key names the timer; arming a timer that is already armed moves its deadline
+//! \param[in] delay_ms how long from now the timer expires
+void TimerWheel::arm(const Key key, const uint64_t delay_ms) {
+    const uint64_t deadline = _now + max<uint64_t>(delay_ms, 1);
+    const uint64_t arming = ++_armings;
+    _timers[key] = {deadline, arming};
+    _place({key, arming}, deadline);
+}
+
+//! \param[in] ms milliseconds since the last call to this method
+//! \details The clock skips ahead over stretches where nothing can expire or cascade.
+vector<TimerWheel::Key> TimerWheel::advance(const uint64_t ms) {
+    vector<Key> expired{};
+    const uint64_t target = _now + ms;
+    while (_now < target) {
+        if (_timers.empty()) {
+            //! Only cancelled entries are left: drop them, and jump to the end.
+            for (auto &level : _slots) {
+                for (auto &slot : level) {
+                    slot.clear();
+                }
+            }
+            _level_entries = {};
+            _overflow.clear();
+            _now = target;
+            break;
+        }
+        if (_level_entries[0] == 0) {
+            //! Nothing happens before level 0 rolls over.
+            const uint64_t skip_to = min(target, _now | (SLOTS - 1));
+            if (skip_to > _now) {
+                _now = skip_to;
+                continue;
+            }
+        }
+        _step(expired);
+    }
+    return expired;
+}
+
+//! \details Every timer in level `k` expires before every timer in level `k + 1`, and within a level
+//! the slots ahead of the clock are in order, so only the first slot with an armed timer is searched.
+optional<uint64_t> TimerWheel::time_until_next() const {
+    if (_timers.empty()) {
+        return nullopt;
+    }
+    for (size_t level = 0; level < LEVELS; level++) {
+        if (_level_entries[level] == 0) {
+            continue;
+        }
+        const unsigned shift = SLOT_BITS * level;
+        for (uint64_t index = ((_now >> shift) & (SLOTS - 1)) + 1; index < SLOTS; index++) {
+            optional<uint64_t> earliest{};
+            for (const auto &entry : _slots[level][index]) {
+                if (_current(entry)) {
+                    const uint64_t deadline = _timers.at(entry.first).deadline;
+                    earliest = min(earliest.value_or(deadline), deadline);
+                }
+            }
+            if (earliest.has_value()) {
+                return earliest.value() - _now;
+            }
+        }
+    }
+    optional<uint64_t> earliest{};
+    for (const auto &entry : _overflow) {
+        if (_current(entry)) {
+            const uint64_t deadline = _timers.at(entry.first).deadline;
+            earliest = min(earliest.value_or(deadline), deadline);
+        }
+    }
+    return earliest.has_value() ? optional<uint64_t>{earliest.value() - _now} : nullopt;
+}
@@ -0,0 +1,79 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//! \brief A hierarchical timing wheel: many timers, each armed and cancelled in O(1)
+//! \details Timers are named by a key and expire a whole number of milliseconds after being armed.
+//! Level `k` of the wheel has SLOTS slots of SLOTS^k ms each; a timer sits in the lowest level
+//! whose span reaches its deadline, and moves down a level each time the wheel turns past the slot
+//! it sits in. Timers further out than the top level wait in an overflow list.
+//!
+//! Cancelling (or re-arming) a timer only forgets it: the entry it left in its slot is dropped
+//! when the wheel reaches that slot. This keeps the wheel free of pointers into itself, so it
+//! can be copied and moved like any other value.
+class TimerWheel {
+  public:
+    using Key = uint64_t;  //!< Names a timer
+
+    static constexpr unsigned SLOT_BITS = 6;           //!< log2 of the number of slots per level
+    static constexpr uint64_t SLOTS = 1 << SLOT_BITS;  //!< Slots per level
+    static constexpr size_t LEVELS = 4;                //!< Levels (the wheel spans SLOTS^LEVELS ms)
+
+  private:
+    //! An entry in a slot: the timer's key and the arming it belongs to
+    using SlotEntry = std::pair<Key, uint64_t>;
+
+    //! An armed timer
+    struct Timer {
+        uint64_t deadline;  //!< When it expires, on the wheel's clock
+        uint64_t arming;    //!< Which arming this is, to recognize the entry it left in its slot
+    };
+
+    uint64_t _now{0};      //!< Milliseconds the wheel has advanced
+    uint64_t _armings{0};  //!< Number of times a timer was armed
+    std::unordered_map<Key, Timer> _timers{};
+
+    std::array<std::array<std::vector<SlotEntry>, SLOTS>, LEVELS> _slots{};
+    std::array<size_t, LEVELS> _level_entries{};  //!< Entries in each level, including cancelled ones
+    std::vector<SlotEntry> _overflow{};
+
+    //! Whether an entry still stands for the timer it was made for
+    bool _current(const SlotEntry &entry) const;
+
+    //! Put a timer's entry in the slot its deadline falls in
+    void _place(const SlotEntry &entry, const uint64_t deadline);
+
+    //! Move the entries of a slot (or the overflow list) down to where they belong now
+    void _cascade(std::vector<SlotEntry> &slot);
+
+    //! Advance the clock by one millisecond, appending the keys of the timers that expire
+    void _step(std::vector<Key> &expired);
+
+  public:
+    //! Start (or restart) the timer `key`, to expire `delay_ms` from now (at least 1 ms)
+    void arm(const Key key, const uint64_t delay_ms);
+
+    //! Stop the timer `key`, if it is armed
+    void cancel(const Key key) { _timers.erase(key); }
+
+    //! Whether the timer `key` is armed
+    bool armed(const Key key) const { return _timers.count(key) > 0; }
+
+    //! Number of armed timers
+    size_t size() const { return _timers.size(); }
+
+    //! Advance the clock, returning the keys of the timers that expired, earliest first
+    std::vector<Key> advance(const uint64_t ms);
+
+    //! Milliseconds until the earliest armed timer expires, or empty if none is armed
+    std::optional<uint64_t> time_until_next() const;
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
@@ -104,6 +104,43 @@ int main() {
             test.execute(Eof{true});
         }
 
+
+        {
+            ByteStreamTestHarness test{"grow-with-wrapped-data", 5};
+
+            test.execute(Write{"abcde"}.with_bytes_written(5));
+            test.execute(Pop{3});
+            test.execute(Write{"fgh"}.with_bytes_written(3));
+            test.execute(RemainingCapacity{0});
+            test.execute(Peek{"defgh"});
+
+            test.execute(SetCapacity{12});
+            test.execute(RemainingCapacity{7});
+            test.execute(Peek{"defgh"});
+            test.execute(Write{"ijklmnop"}.with_bytes_written(7));
+            test.execute(RemainingCapacity{0});
+            test.execute(Peek{"defghijklmno"});
+        }
+
+        {
+            ByteStreamTestHarness test{"shrink", 12};
+
+            test.execute(Write{"abcdefghijkl"}.with_bytes_written(12));
+            test.execute(SetCapacity{4});
+            test.execute(RemainingCapacity{0});
+            test.execute(Peek{"abcdefghijkl"});
+
+            test.execute(Pop{10});
+            test.execute(SetCapacity{4});
+            test.execute(RemainingCapacity{2});
+            test.execute(Peek{"kl"});
+            test.execute(Write{"xyz"}.with_bytes_written(2));
+            test.execute(Peek{"klxy"});
+            test.execute(Pop{4});
+            test.execute(Write{"12345"}.with_bytes_written(4));
+            test.execute(Peek{"1234"});
+        }
+
     } catch (const exception &e) {
         cerr << "Exception: " << e.what() << endl;
         return EXIT_FAILURE;
@@ -5,6 +5,15 @@
 
 using namespace std;
 
+//! \returns the strings in `parts`, quoted and separated by commas, inside braces
+static std::string join_quoted(const std::vector<std::string> &parts) {
+    std::string s = "{";
+    for (size_t i = 0; i < parts.size(); ++i) {
+        s += (i ? ", \"" : "\"") + parts[i] + "\"";
+    }
+    return s + "}";
+}
+
 // ByteStreamTestStep
 
 ByteStreamTestStep::operator std::string() const { return "ByteStreamTestStep"; }
@@ -97,11 +106,85 @@ void Write::execute(ByteStream &bs) const {
     }
 }
 
+// WriteBuffer
+WriteBuffer::WriteBuffer(const std::string &data) : _data(data) {}
+WriteBuffer &WriteBuffer::with_bytes_written(const size_t bytes_written) {
+    _bytes_written = bytes_written;
+    return *this;
+}
+std::string WriteBuffer::description() const { return "write Buffer \"" + _data + "\" to the stream"; }
+void WriteBuffer::execute(ByteStream &bs) const {
+    auto bytes_written = bs.write(Buffer{string{_data}});
+    if (_bytes_written and bytes_written != _bytes_written.value()) {
+        throw ByteStreamExpectationViolation::property("bytes_written", _bytes_written.value(), bytes_written);
+    }
+}
+
+// WriteBuffers
+WriteBuffers::WriteBuffers(const std::vector<std::string> &data) : _data(data) {}
+WriteBuffers &WriteBuffers::with_bytes_written(const size_t bytes_written) {
+    _bytes_written = bytes_written;
+    return *this;
+}
+std::string WriteBuffers::description() const { return "write BufferList " + join_quoted(_data) + " to the stream"; }
+void WriteBuffers::execute(ByteStream &bs) const {
+    BufferList buffers;
+    for (const auto &data : _data) {
+        buffers.append(BufferList{string{data}});
+    }
+    auto bytes_written = bs.write(buffers);
+    if (_bytes_written and bytes_written != _bytes_written.value()) {
+        throw ByteStreamExpectationViolation::property("bytes_written", _bytes_written.value(), bytes_written);
+    }
+}
+
 // Pop
 Pop::Pop(const size_t len) : _len(len) {}
 std::string Pop::description() const { return "pop " + to_string(_len); }
 void Pop::execute(ByteStream &bs) const { bs.pop_output(_len); }
 
+// ReadInto
+ReadInto::ReadInto(const std::vector<size_t> &lens) : _lens(lens) {}
+ReadInto &ReadInto::with_data(const std::string &data) {
+    _data = data;
+    return *this;
+}
+std::string ReadInto::description() const {
+    std::string lens;
+    for (const size_t len : _lens) {
+        lens += (lens.empty() ? "" : ", ") + to_string(len);
+    }
+    return "read \"" + _data + "\" into regions of {" + lens + "} bytes";
+}
+void ReadInto::execute(ByteStream &bs) const {
+    // Bytes the stream doesn't fill keep this marker, so a copy past the end of the data shows up.
+    std::vector<std::string> regions;
+    for (const size_t len : _lens) {
+        regions.emplace_back(len, '.');
+    }
+    std::vector<iovec> iov;
+    for (auto &region : regions) {
+        iov.push_back({region.data(), region.size()});
+    }
+    auto bytes_read = bs.read_into(iov.data(), iov.size());
+    if (bytes_read != _data.size()) {
+        throw ByteStreamExpectationViolation::property("bytes_read", _data.size(), bytes_read);
+    }
+    std::string output;
+    for (const auto &region : regions) {
+        output += region;
+    }
+    if (output != _data + std::string(output.size() - _data.size(), '.')) {
+        throw ByteStreamExpectationViolation("Expected \"" + _data + "\" at the front of the regions, but found \"" +
+                                             output + "\"");
+    }
+}
+
+// SetCapacity
+SetCapacity::SetCapacity(const size_t capacity) : _capacity(capacity) {}
+std::string SetCapacity::description() const { return "set capacity to " + to_string(_capacity); }
+void SetCapacity::execute(ByteStream &bs) const { bs.set_capacity(_capacity); }
+
 // InputEnded
 InputEnded::InputEnded(const bool input_ended) : _input_ended(input_ended) {}
 std::string InputEnded::description() const { return "input_ended: " + to_string(_input_ended); }
@@ -182,3 +265,22 @@ void Peek::execute(ByteStream &bs) const {
                                              output + "\"");
     }
 }
+
+// PeekBuffers
+PeekBuffers::PeekBuffers(const size_t len, const std::vector<std::string> &views) : _len(len), _views(views) {}
+std::string PeekBuffers::description() const {
+    return join_quoted(_views) + " as views of the first " + to_string(_len) + " bytes";
+}
+void PeekBuffers::execute(ByteStream &bs) const {
+    // Empty views carry no bytes for writev(2), so only the non-empty ones are compared.
+    std::vector<std::string> views;
+    for (const auto &iov : bs.peek_buffers(_len).as_iovecs()) {
+        if (iov.iov_len > 0) {
+            views.emplace_back(static_cast<const char *>(iov.iov_base), iov.iov_len);
+        }
+    }
+    if (views != _views) {
+        throw ByteStreamExpectationViolation("Expected " + join_quoted(_views) + " as views of the stream, but found " +
+                                             join_quoted(views));
+    }
+}
@@ -10,6 +10,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 struct ByteStreamTestStep {
     virtual operator std::string() const;
@@ -56,6 +57,26 @@ struct Write : public ByteStreamAction {
     void execute(ByteStream &) const override;
 };
 
+struct WriteBuffer : public ByteStreamAction {
+    std::string _data;
+    std::optional<size_t> _bytes_written{};
+
+    WriteBuffer(const std::string &data);
+    WriteBuffer &with_bytes_written(const size_t bytes_written);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
+struct WriteBuffers : public ByteStreamAction {
+    std::vector<std::string> _data;
+    std::optional<size_t> _bytes_written{};
+
+    WriteBuffers(const std::vector<std::string> &data);
+    WriteBuffers &with_bytes_written(const size_t bytes_written);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 struct Pop : public ByteStreamAction {
     size_t _len;
 
@@ -64,6 +85,24 @@ struct Pop : public ByteStreamAction {
     void execute(ByteStream &) const override;
 };
 
+struct ReadInto : public ByteStreamAction {
+    std::vector<size_t> _lens;
+    std::string _data{};
+
+    ReadInto(const std::vector<size_t> &lens);
+    ReadInto &with_data(const std::string &data);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
+struct SetCapacity : public ByteStreamAction {
+    size_t _capacity;
+
+    SetCapacity(const size_t capacity);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 struct InputEnded : public ByteStreamExpectation {
     bool _input_ended;
 
@@ -128,6 +167,15 @@ struct Peek : public ByteStreamExpectation {
     void execute(ByteStream &) const override;
 };
 
+struct PeekBuffers : public ByteStreamExpectation {
+    size_t _len;
+    std::vector<std::string> _views;
+
+    PeekBuffers(const size_t len, const std::vector<std::string> &views);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 class ByteStreamTestHarness {
     std::string _test_name;
     ByteStream _byte_stream;
@@ -0,0 +1,103 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"buffer-write-wraps", 8};
+
+            test.execute(WriteBuffer{"abcdef"}.with_bytes_written(6));
+            test.execute(Pop{4});
+            test.execute(WriteBuffer{"ghijkl"}.with_bytes_written(6));
+
+            test.execute(BytesWritten{12});
+            test.execute(RemainingCapacity{0});
+            test.execute(BufferSize{8});
+            test.execute(PeekBuffers{8, {"efgh", "ijkl"}});
+            test.execute(PeekBuffers{3, {"efg"}});
+            test.execute(Peek{"efghijkl"});
+        }
+
+        {
+            ByteStreamTestHarness test{"buffer-write-full", 8};
+
+            test.execute(WriteBuffer{"abcdefgh"}.with_bytes_written(8));
+            test.execute(WriteBuffer{"i"}.with_bytes_written(0));
+
+            test.execute(BytesWritten{8});
+            test.execute(RemainingCapacity{0});
+            test.execute(PeekBuffers{8, {"abcdefgh"}});
+            test.execute(PeekBuffers{100, {"abcdefgh"}});
+            test.execute(Pop{8});
+            test.execute(PeekBuffers{8, {}});
+        }
+
+        {
+            ByteStreamTestHarness test{"buffer-write-empty", 8};
+
+            test.execute(PeekBuffers{8, {}});
+            test.execute(WriteBuffer{""}.with_bytes_written(0));
+            test.execute(WriteBuffers{{}}.with_bytes_written(0));
+            test.execute(WriteBuffers{{"", ""}}.with_bytes_written(0));
+
+            test.execute(BufferEmpty{true});
+            test.execute(BytesWritten{0});
+            test.execute(PeekBuffers{8, {}});
+        }
+
+        {
+            ByteStreamTestHarness test{"buffer-list-partial-write", 8};
+
+            test.execute(WriteBuffers{{"abc", "defg", "hij"}}.with_bytes_written(8));
+            test.execute(PeekBuffers{8, {"abcdefgh"}});
+            test.execute(Pop{3});
+            test.execute(WriteBuffers{{"", "xy", "z12", "34"}}.with_bytes_written(3));
+
+            test.execute(BytesWritten{11});
+            test.execute(RemainingCapacity{0});
+            test.execute(PeekBuffers{8, {"defgh", "xyz"}});
+            test.execute(Peek{"defghxyz"});
+            test.execute(WriteBuffers{{"5"}}.with_bytes_written(0));
+        }
+
+        {
+            ByteStreamTestHarness test{"read-into-regions", 8};
+
+            test.execute(Write{"abcdefg"}.with_bytes_written(7));
+            test.execute(ReadInto{{3, 0, 2}}.with_data("abcde"));
+            test.execute(BytesRead{5});
+            test.execute(BufferSize{2});
+            test.execute(ReadInto{{0, 10}}.with_data("fg"));
+            test.execute(BufferEmpty{true});
+            test.execute(ReadInto{{4}}.with_data(""));
+            test.execute(ReadInto{{}}.with_data(""));
+            test.execute(BytesRead{7});
+        }
+
+        {
+            ByteStreamTestHarness test{"read-into-wraps", 8};
+
+            test.execute(Write{"abcdef"}.with_bytes_written(6));
+            test.execute(Pop{4});
+            test.execute(Write{"ghijkl"}.with_bytes_written(6));
+            test.execute(ReadInto{{3, 6}}.with_data("efghijkl"));
+
+            test.execute(BytesRead{12});
+            test.execute(RemainingCapacity{8});
+            test.execute(Write{"mnop"}.with_bytes_written(4));
+            test.execute(ReadInto{{1, 100}}.with_data("mnop"));
+            test.execute(BufferEmpty{true});
+        }
+
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+// 100 ms after the SYN/ACK, the peer sends past the window it advertised (an RTT sample of 100 ms),
+// and the application reads everything: 2500 bytes in the first RTT
+void drain_first_rtt(TCPTestHarness &test, const WrappingInt32 isn, const WrappingInt32 base) {
+    test.execute(Tick(100));
+    test.execute(SendSegment{}.with_ack(true).with_ackno(base).with_seqno(isn + 1).with_data(string(MSS, 'x')));
+    test.execute(ExpectOneSegment{}.with_ackno(isn + 1 + MSS).with_win(MSS));
+    test.execute(ExpectData{}.with_data(string(MSS, 'x')));
+    test.execute(
+        SendSegment{}.with_ack(true).with_ackno(base).with_seqno(isn + 1 + MSS).with_data(string(3 * MSS / 2, 'y')));
+    test.execute(ExpectOneSegment{}.with_ackno(isn + 1 + 5 * MSS / 2).with_win(MSS / 2));
+    test.execute(ExpectData{}.with_data(string(3 * MSS / 2, 'y')));
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: the buffer grows to twice what the application drains per RTT, and shrinks back when idle
+        {
+            TCPConfig cfg{};
+            cfg.recv_autotuning = true;
+            cfg.recv_capacity = 2 * MSS;
+            cfg.recv_capacity_max = 64000;
+            const WrappingInt32 isn(rd()), tx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, isn, 1000);
+            const WrappingInt32 base = tx_isn + 1;
+
+            drain_first_rtt(test_1, isn, base);
+            test_1.execute(Tick(1));
+            test_1.execute(ExpectOneSegment{}.with_ackno(isn + 1 + 5 * MSS / 2).with_win(5 * MSS),
+                           "test 1 failed: the window didn't grow with the drain rate");
+
+            // draining less later on leaves it as it is
+            test_1.execute(
+                SendSegment{}.with_ack(true).with_ackno(base).with_seqno(isn + 1 + 5 * MSS / 2).with_data("z"));
+            test_1.execute(ExpectOneSegment{}.with_ackno(isn + 2 + 5 * MSS / 2).with_win(5 * MSS - 1));
+            test_1.execute(ExpectData{}.with_data("z"));
+            test_1.execute(Tick(200));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: the window changed though the drain rate fell");
+            test_1.execute(ExpectNextTimer{TCPConfig::RECV_IDLE_MS - 200});
+
+            test_1.execute(Tick(TCPConfig::RECV_IDLE_MS - 201));
+            test_1.execute(ExpectNoSegment{});
+            test_1.execute(Tick(1));
+            test_1.execute(ExpectOneSegment{}.with_ackno(isn + 2 + 5 * MSS / 2).with_win(2 * MSS),
+                           "test 1 failed: the idle connection kept its grown buffer");
+            test_1.execute(ExpectNextTimer{std::nullopt});
+        }
+
+        // test 2: growth stops at recv_capacity_max
+        {
+            TCPConfig cfg{};
+            cfg.recv_autotuning = true;
+            cfg.recv_capacity = 2 * MSS;
+            cfg.recv_capacity_max = 3 * MSS;
+            const WrappingInt32 isn(rd()), tx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, isn, 1000);
+            const WrappingInt32 base = tx_isn + 1;
+
+            drain_first_rtt(test_2, isn, base);
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectOneSegment{}.with_ackno(isn + 1 + 5 * MSS / 2).with_win(3 * MSS),
+                           "test 2 failed: the window grew past recv_capacity_max");
+        }
+
+        // test 3: without autotuning, the buffer stays as configured
+        {
+            TCPConfig cfg{};
+            cfg.recv_capacity = 2 * MSS;
+            const WrappingInt32 isn(rd()), tx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(cfg, tx_isn, isn, 1000);
+            const WrappingInt32 base = tx_isn + 1;
+
+            drain_first_rtt(test_3, isn, base);
+            test_3.execute(Tick(1));
+            test_3.execute(ExpectOneSegment{}.with_ackno(isn + 1 + 5 * MSS / 2).with_win(2 * MSS));
+            test_3.execute(Tick(TCPConfig::RECV_IDLE_MS));
+            test_3.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
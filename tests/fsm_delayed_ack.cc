@@ -0,0 +1,135 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+void send_full_segment(TCPTestHarness &test, const WrappingInt32 seqno, const WrappingInt32 ackno) {
+    test.execute(SendSegment{}.with_ack(true).with_ackno(ackno).with_seqno(seqno).with_win(1000).with_data(
+        string(MSS, 'x')));
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.delayed_ack_ms = 40;
+
+        // test 1: one segment is acknowledged after the delay, two at once
+        {
+            const WrappingInt32 isn(rd()), tx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, isn);
+            const WrappingInt32 ack_base = tx_isn + 1;
+
+            send_full_segment(test_1, isn + 1, ack_base);
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: a lone segment was ACKed at once");
+            test_1.execute(ExpectNextTimer{40}, "test 1 failed: the held ACK should be the next timer");
+            test_1.execute(Tick(39));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: ACK sent before the delay");
+            test_1.execute(ExpectNextTimer{1});
+            test_1.execute(Tick(1));
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 1 + MSS));
+            test_1.execute(ExpectNextTimer{std::nullopt}, "test 1 failed: no timer should run once the ACK is out");
+
+            send_full_segment(test_1, isn + 1 + MSS, ack_base);
+            test_1.execute(ExpectNoSegment{});
+            send_full_segment(test_1, isn + 1 + 2 * MSS, ack_base);
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 1 + 3 * MSS),
+                           "test 1 failed: the second full-size segment should be ACKed at once");
+            test_1.execute(Tick(40));
+            test_1.execute(ExpectNoSegment{});
+        }
+
+        // test 2: out-of-order data, and data filling the hole, are acknowledged at once
+        {
+            const WrappingInt32 isn(rd()), tx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, isn);
+            const WrappingInt32 ack_base = tx_isn + 1;
+
+            send_full_segment(test_2, isn + 1 + MSS, ack_base);
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 1),
+                           "test 2 failed: out-of-order data should be ACKed at once");
+            send_full_segment(test_2, isn + 1, ack_base);
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 1 + 2 * MSS),
+                           "test 2 failed: data filling a hole should be ACKed at once");
+            // a FIN isn't delayed either
+            test_2.send_fin(isn + 1 + 2 * MSS, ack_base);
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 2 + 2 * MSS));
+        }
+
+        // test 3: stretch ACKs cover more segments
+        {
+            TCPConfig stretch_cfg = cfg;
+            stretch_cfg.ack_every = 4;
+            const WrappingInt32 isn(rd()), tx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(stretch_cfg, tx_isn, isn);
+            const WrappingInt32 ack_base = tx_isn + 1;
+
+            for (unsigned i = 0; i < 3; i++) {
+                send_full_segment(test_3, isn + 1 + i * MSS, ack_base);
+                test_3.execute(ExpectNoSegment{});
+            }
+            send_full_segment(test_3, isn + 1 + 3 * MSS, ack_base);
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 1 + 4 * MSS));
+        }
+
+        // test 4: a held ACK goes out early once reading opens up the window
+        {
+            TCPConfig small_cfg = cfg;
+            small_cfg.recv_capacity = 4 * MSS;
+            const WrappingInt32 isn(rd()), tx_isn(rd());
+            TCPTestHarness test_4 = TCPTestHarness::in_established(small_cfg, tx_isn, isn);
+            const WrappingInt32 ack_base = tx_isn + 1;
+
+            send_full_segment(test_4, isn + 1, ack_base);
+            send_full_segment(test_4, isn + 1 + MSS, ack_base);
+            test_4.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 1 + 2 * MSS).with_win(2 * MSS));
+            send_full_segment(test_4, isn + 1 + 2 * MSS, ack_base);
+            test_4.execute(ExpectNoSegment{});
+            test_4.execute(ExpectData{}.with_data(string(3 * MSS, 'x')));
+            test_4.execute(Tick(1));
+            test_4.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 1 + 3 * MSS).with_win(4 * MSS),
+                           "test 4 failed: the window update should not wait for the delay");
+        }
+
+        // test 5: "full-size" is the peer's MSS, when its SYN announced a smaller one
+        {
+            const size_t peer_mss = MSS / 2;
+            const WrappingInt32 isn(rd());
+            TCPTestHarness test_5(cfg);
+            test_5.execute(Listen{});
+            test_5.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_win(1000).with_mss(peer_mss));
+            const TCPSegment syn_ack = test_5.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                         "test 5 failed: SYN/ACK invalid");
+            test_5.send_ack(isn + 1, syn_ack.header().seqno + 1);
+
+            for (unsigned i = 0; i < 2; i++) {
+                test_5.execute(SendSegment{}
+                                   .with_ack(true)
+                                   .with_ackno(syn_ack.header().seqno + 1)
+                                   .with_seqno(isn + 1 + i * peer_mss)
+                                   .with_win(1000)
+                                   .with_data(string(peer_mss, 'x')));
+            }
+            test_5.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 1 + 2 * peer_mss),
+                           "test 5 failed: the second segment of the peer's MSS should be ACKed at once");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: a super-segment is split into MSS-sized wire segments
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32{static_cast<uint32_t>(rd())};
+            seg.header().ack = true;
+            seg.header().fin = true;
+            seg.payload() = string(2 * MSS + 10, 'x');
+            test_err_if(seg.wire_segments().size() != 1, "test 1 failed: no GSO size should mean no split");
+
+            seg.set_gso_size(MSS);
+            const auto wire_segs = seg.wire_segments();
+            test_err_if(wire_segs.size() != 3, "test 1 failed: expected three wire segments");
+            for (size_t i = 0; i < wire_segs.size(); i++) {
+                const TCPHeader &hdr = wire_segs[i].header();
+                test_err_if(hdr.seqno != seg.header().seqno + i * MSS, "test 1 failed: wrong seqno");
+                test_err_if(not hdr.ack, "test 1 failed: every wire segment should keep the ACK flag");
+                test_err_if(hdr.fin != (i == 2), "test 1 failed: only the last wire segment should carry the FIN");
+                test_err_if(wire_segs[i].payload().str() != seg.payload().str().substr(i * MSS, MSS),
+                            "test 1 failed: wrong payload");
+            }
+        }
+
+        // test 2: the sender builds super-segments; the adapter sees MSS-sized ones, and a
+        // retransmission resends one MSS of what is still unacknowledged
+        {
+            TCPConfig cfg{};
+            cfg.segmentation_offload = true;
+            const WrappingInt32 isn(rd());
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Listen{});
+            test_2.send_syn(isn);
+            const TCPSegment syn_ack = test_2.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                         "test 2 failed: SYN/ACK invalid");
+            const WrappingInt32 base = syn_ack.header().seqno + 1;
+            test_2.send_ack(isn + 1, base, 5 * MSS);
+            test_2.execute(ExpectState{State::ESTABLISHED});
+
+            // one byte short of ten segments, so the last has room for the FIN
+            test_2.execute(Write{string(10 * MSS - 1, 'x')}.with_bytes_written(10 * MSS - 1));
+            test_2.execute(Close{});
+            for (size_t i = 0; i < 5; i++) {
+                test_2.execute(
+                    ExpectSegment{}.with_seqno(base + i * MSS).with_payload_size(MSS).with_fin(false),
+                    "test 2 failed: the first super-segment should go out as five wire segments");
+            }
+            test_2.execute(ExpectNoSegment{});
+
+            test_2.send_ack(isn + 1, base + 5 * MSS, 10 * MSS);
+            for (size_t i = 5; i < 10; i++) {
+                const bool last = i == 9;
+                test_2.execute(
+                    ExpectSegment{}.with_seqno(base + i * MSS).with_payload_size(last ? MSS - 1 : MSS).with_fin(last),
+                    "test 2 failed: the second super-segment should go out as five wire segments, FIN on the last");
+            }
+            test_2.execute(ExpectNoSegment{});
+            test_2.execute(ExpectBytesInFlight{5 * MSS});
+
+            // part of the super-segment is acknowledged; the timeout resends one MSS after it
+            test_2.send_ack(isn + 1, base + 7 * MSS, 10 * MSS);
+            test_2.execute(ExpectBytesInFlight{3 * MSS});
+            test_2.execute(Tick(TCPConfig::TIMEOUT_DFLT));
+            test_2.execute(
+                ExpectOneSegment{}.with_seqno(base + 7 * MSS).with_payload_size(MSS).with_fin(false),
+                "test 2 failed: the retransmission should be the first unacknowledged MSS");
+
+            test_2.send_ack(isn + 1, base + 10 * MSS, 10 * MSS);
+            test_2.execute(ExpectBytesInFlight{0});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
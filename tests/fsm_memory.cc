@@ -0,0 +1,106 @@
+#include "memory_budget.hh"
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: the send buffer grows to twice the window
+        {
+            TCPConfig cfg{};
+            cfg.send_capacity = 2 * MSS;
+            cfg.send_autotuning = true;
+            const WrappingInt32 isn(rd()), tx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, isn, 10 * MSS);
+
+            test_1.execute(Write{string(30 * MSS, 'x')}.with_bytes_written(20 * MSS),
+                           "test 1 failed: the send buffer didn't grow with the window");
+        }
+
+        // test 2: under memory pressure, it doesn't grow, and shrinks back if it has
+        {
+            const auto budget = make_shared<MemoryBudget>(100 * MSS, 30 * MSS);
+            TCPConfig cfg{};
+            cfg.send_capacity = 2 * MSS;
+            cfg.recv_capacity = 2 * MSS;
+            cfg.send_autotuning = true;
+            cfg.memory_budget = budget;
+            {
+                TCPTestHarness unopened(cfg);
+                test_err_if(budget->allocated() != 4 * MSS, "test 2 failed: the connection didn't charge its buffers");
+            }
+            const WrappingInt32 isn(rd()), tx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, isn, 10 * MSS);
+            test_err_if(budget->allocated() != 22 * MSS, "test 2 failed: the grown send buffer wasn't charged");
+
+            budget->charge(10 * MSS);
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: the receive window changed under pressure");
+            test_err_if(budget->allocated() != 14 * MSS, "test 2 failed: the grown send buffer wasn't given back");
+            test_2.execute(Write{string(30 * MSS, 'x')}.with_bytes_written(2 * MSS),
+                           "test 2 failed: the send buffer stayed grown under pressure");
+            budget->release(10 * MSS);
+        }
+
+        // test 3: connections share a budget; past its limit, the receive window closes until memory is freed
+        {
+            const auto budget = make_shared<MemoryBudget>(10 * MSS, 8 * MSS);
+            {
+                TCPConfig cfg{};
+                cfg.send_capacity = 2 * MSS;
+                cfg.recv_capacity = 2 * MSS;
+                cfg.send_autotuning = true;
+                cfg.memory_budget = budget;
+                TCPTestHarness other(cfg);
+                const WrappingInt32 isn(rd()), tx_isn(rd());
+                TCPTestHarness test_3 = TCPTestHarness::in_established(cfg, tx_isn, isn, 10 * MSS);
+                const WrappingInt32 base = tx_isn + 1;
+                test_err_if(budget->allocated() != 8 * MSS,
+                            "test 3 failed: the buffer grew past the pressure threshold");
+
+                test_3.execute(Write{string(5 * MSS, 'x')}.with_bytes_written(2 * MSS));
+                test_3.execute(ExpectSegment{}.with_seqno(base).with_data(string(MSS, 'x')));
+                test_3.execute(ExpectOneSegment{}.with_seqno(base + MSS).with_data(string(MSS, 'x')));
+                test_3.send_ack(isn + 1, base + 2 * MSS, 10 * MSS);
+
+                budget->charge(3 * MSS);
+                test_3.execute(Tick(1));
+                test_3.execute(ExpectOneSegment{}.with_ackno(isn + 1).with_win(0),
+                               "test 3 failed: the receive window didn't close past the limit");
+                test_3.execute(Write{"x"}.with_bytes_written(0), "test 3 failed: the send buffer wasn't emptied");
+                test_3.execute(Tick(1));
+                test_3.execute(ExpectNoSegment{}, "test 3 failed: the buffers came back under pressure");
+
+                budget->release(3 * MSS);
+                test_3.execute(Tick(1));
+                test_3.execute(ExpectOneSegment{}.with_ackno(isn + 1).with_win(2 * MSS),
+                               "test 3 failed: the receive window didn't reopen once memory was freed");
+                test_3.execute(Write{string(5 * MSS, 'x')}.with_bytes_written(2 * MSS));
+            }
+            test_err_if(budget->allocated() != 0, "test 3 failed: connections didn't give their memory back");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
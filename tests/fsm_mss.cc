@@ -0,0 +1,108 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+static constexpr size_t OUR_MSS = 1460;
+
+// Drain the segments sent so far, checking none is larger than `mss`; returns the number of full-sized ones
+size_t count_full_segments(TCPTestHarness &test, const size_t mss) {
+    size_t full = 0;
+    while (test.can_read()) {
+        const TCPSegment seg = test.expect_seg(ExpectSegment{}.with_ack(true), "invalid segment carrying data");
+        test_err_if(seg.payload().size() > mss, "segment larger than the MSS");
+        full += seg.payload().size() == mss;
+    }
+    return full;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.mss = OUR_MSS;
+
+        // test 1: the active opener sends its MSS, and uses the peer's smaller one
+        {
+            const WrappingInt32 isn(rd());
+            TCPTestHarness test_1(cfg);
+            test_1.execute(Connect{});
+            const TCPSegment syn = test_1.expect_seg(ExpectOneSegment{}.with_syn(true), "test 1 failed: no SYN");
+            test_err_if(syn.header().mss != optional<uint16_t>{OUR_MSS}, "test 1 failed: SYN should carry our MSS");
+
+            test_1.execute(SendSegment{}.with_syn(true).with_ack(true).with_seqno(isn).with_ackno(
+                syn.header().seqno + 1).with_win(10'000).with_mss(536));
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 1).with_payload_size(0));
+            test_1.execute(ExpectState{State::ESTABLISHED});
+            test_1.execute(Write{string(5000, 'x')}.with_bytes_written(5000));
+            test_1.execute(Tick(1));
+            test_err_if(count_full_segments(test_1, 536) != 5000 / 536, "test 1 failed: segments should be 536 bytes");
+        }
+
+        // test 2: without an MSS option, the passive opener sends at its own MSS; the SYN/ACK carries it
+        {
+            const WrappingInt32 isn(rd());
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Listen{});
+            test_2.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_win(10'000));
+            const TCPSegment syn_ack = test_2.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                         "test 2 failed: SYN/ACK invalid");
+            test_err_if(syn_ack.header().mss != optional<uint16_t>{OUR_MSS},
+                        "test 2 failed: SYN/ACK should carry our MSS");
+
+            test_2.send_ack(isn + 1, syn_ack.header().seqno + 1, 10'000);
+            test_2.execute(Write{string(5000, 'x')}.with_bytes_written(5000));
+            test_2.execute(Tick(1));
+            test_err_if(count_full_segments(test_2, OUR_MSS) != 5000 / OUR_MSS,
+                        "test 2 failed: segments should be our MSS");
+        }
+
+        // test 3: a peer MSS larger than ours doesn't raise it
+        {
+            const WrappingInt32 isn(rd());
+            TCPTestHarness test_3(cfg);
+            test_3.execute(Listen{});
+            test_3.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_win(10'000).with_mss(8960));
+            const TCPSegment syn_ack = test_3.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                         "test 3 failed: SYN/ACK invalid");
+
+            test_3.send_ack(isn + 1, syn_ack.header().seqno + 1, 10'000);
+            test_3.execute(Write{string(5000, 'x')}.with_bytes_written(5000));
+            test_3.execute(Tick(1));
+            test_err_if(count_full_segments(test_3, OUR_MSS) != 5000 / OUR_MSS,
+                        "test 3 failed: segments should not exceed our MSS");
+        }
+
+        // test 4: an MSS of zero is rejected
+        {
+            TCPConfig zero_cfg{};
+            zero_cfg.mss = 0;
+            bool threw = false;
+            try {
+                TCPTestHarness test_4(zero_cfg);
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            test_err_if(not threw, "test 4 failed: a connection with an MSS of zero was created");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
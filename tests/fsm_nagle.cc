@@ -0,0 +1,86 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: with Nagle's algorithm, small writes wait while data is unacknowledged
+        {
+            TCPConfig cfg{};
+            cfg.nagle = true;
+            const WrappingInt32 isn(rd()), tx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, isn, 10 * MSS);
+            const WrappingInt32 base = tx_isn + 1;
+
+            test_1.execute(Write{string(100, 'a')});
+            test_1.execute(ExpectOneSegment{}.with_seqno(base).with_payload_size(100),
+                           "test 1 failed: nothing in flight, so a small write should go out at once");
+            test_1.execute(Write{string(100, 'b')});
+            test_1.execute(Write{string(100, 'c')});
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: small writes should wait for the ACK");
+
+            test_1.send_ack(isn + 1, base + 100, 10 * MSS);
+            test_1.execute(ExpectOneSegment{}.with_seqno(base + 100).with_data(string(100, 'b') + string(100, 'c')),
+                           "test 1 failed: the ACK should release the held data as one segment");
+
+            // a full segment goes out at once; only the partial tail waits
+            test_1.execute(Write{string(MSS + 50, 'd')});
+            test_1.execute(ExpectOneSegment{}.with_seqno(base + 300).with_payload_size(MSS));
+            test_1.send_ack(isn + 1, base + 300 + MSS, 10 * MSS);
+            test_1.execute(ExpectOneSegment{}.with_seqno(base + 300 + MSS).with_payload_size(50));
+
+            // the end of the stream isn't held back
+            test_1.execute(Write{string(10, 'e')});
+            test_1.execute(Close{});
+            test_1.execute(ExpectOneSegment{}.with_seqno(base + 350 + MSS).with_payload_size(10).with_fin(true));
+        }
+
+        // test 2: a corked connection sends only full segments, until uncorked or the cork times out
+        {
+            TCPConfig cfg{};
+            cfg.cork = true;
+            const WrappingInt32 isn(rd()), tx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, isn, 10 * MSS);
+            const WrappingInt32 base = tx_isn + 1;
+
+            test_2.execute(Write{string(100, 'a')});
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: a corked partial segment should wait");
+            test_2.execute(Write{string(MSS, 'b')});
+            test_2.execute(ExpectOneSegment{}.with_seqno(base).with_payload_size(MSS));
+            test_2.execute(Tick(TCPConfig::CORK_TIMEOUT_MS - 1));
+            test_2.execute(ExpectNoSegment{});
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectOneSegment{}.with_seqno(base + MSS).with_payload_size(100),
+                           "test 2 failed: the cork should time out");
+
+            test_2.execute(Write{string(200, 'c')});
+            test_2.execute(ExpectNoSegment{});
+            test_2.execute(SetCorked{false});
+            test_2.execute(ExpectOneSegment{}.with_seqno(base + MSS + 100).with_payload_size(200),
+                           "test 2 failed: uncorking should send the held data");
+            test_2.execute(Write{string(10, 'd')});
+            test_2.execute(ExpectOneSegment{}.with_payload_size(10), "test 2 failed: uncorked writes go out");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: probes of a zero window back off, up to max_rto, and never give up
+        {
+            TCPConfig cfg{};
+            cfg.persist_timer = true;
+            cfg.rt_timeout = 100;
+            cfg.max_rto = 400;
+            const WrappingInt32 isn(rd()), tx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, isn, 0);
+            const WrappingInt32 base = tx_isn + 1;
+
+            test_1.execute(Write{"abc"});
+            test_1.execute(ExpectOneSegment{}.with_seqno(base).with_data("a"), "test 1 failed: no probe");
+            for (const size_t interval : {100, 200, 400, 400, 400, 400, 400, 400, 400, 400}) {
+                test_1.execute(Tick(interval - 1));
+                test_1.execute(ExpectNoSegment{}, "test 1 failed: probe sent before its backed-off timeout");
+                test_1.execute(Tick(1));
+                test_1.execute(ExpectOneSegment{}.with_seqno(base).with_data("a"), "test 1 failed: missing probe");
+                test_1.send_ack(isn + 1, base, 0);
+            }
+            test_1.execute(ExpectState{State::ESTABLISHED}, "test 1 failed: unanswered probes aborted the connection");
+
+            // the window reopens without the probe having been accepted: it is resent at once, with what follows
+            test_1.send_ack(isn + 1, base, 1000);
+            test_1.execute(ExpectSegment{}.with_seqno(base).with_data("a"), "test 1 failed: probe not resent at once");
+            test_1.execute(ExpectOneSegment{}.with_seqno(base + 1).with_data("bc"));
+
+            // and the RTO is back to normal
+            test_1.execute(Tick(99));
+            test_1.execute(ExpectNoSegment{});
+            test_1.execute(Tick(1));
+            test_1.execute(ExpectOneSegment{}.with_seqno(base).with_data("a"));
+        }
+
+        // test 2: the receiver reports a window reopened by the application reading
+        {
+            TCPConfig cfg{};
+            cfg.recv_capacity = 2 * MSS;
+            const WrappingInt32 isn(rd()), tx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, isn, 1000);
+            const WrappingInt32 base = tx_isn + 1;
+
+            // reading a little isn't worth an update (silly window avoidance)
+            test_2.execute(
+                SendSegment{}.with_ack(true).with_ackno(base).with_seqno(isn + 1).with_data(string(50, 'x')));
+            test_2.execute(ExpectOneSegment{}.with_ackno(isn + 51).with_win(2 * MSS - 50));
+            test_2.execute(ExpectData{}.with_data(string(50, 'x')));
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: window update for a small read");
+
+            // but reading what closed the window is
+            test_2.execute(SendSegment{}.with_ack(true).with_ackno(base).with_seqno(isn + 51).with_data(
+                string(2 * MSS, 'y')));
+            test_2.execute(ExpectOneSegment{}.with_ackno(isn + 51 + 2 * MSS).with_win(0));
+            test_2.execute(ExpectData{}.with_data(string(2 * MSS, 'y')));
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectOneSegment{}.with_ackno(isn + 51 + 2 * MSS).with_win(2 * MSS),
+                           "test 2 failed: no window update after the application read");
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: window update sent twice");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -159,12 +159,24 @@ struct SubmitSegment : public ReassemblerAction {
     void execute(StreamReassembler &reassembler) const { reassembler.push_substring(_data, _index, _eof); }
 };
 
+struct Resize : public ReassemblerAction {
+    size_t _capacity;
+
+    Resize(const size_t capacity) : _capacity(capacity) {}
+
+    std::string description() const { return "capacity set to `" + std::to_string(_capacity) + "`"; }
+
+    void execute(StreamReassembler &reassembler) const { reassembler.set_capacity(_capacity); }
+};
+
 class ReassemblerTestHarness {
     StreamReassembler reassembler;
     std::vector<std::string> steps_executed;
 
   public:
-    ReassemblerTestHarness(const size_t capacity) : reassembler(capacity), steps_executed() {
+    ReassemblerTestHarness(const size_t capacity,
+                           const StreamReassembler::Storage storage = StreamReassembler::Storage::Segments)
+        : reassembler(capacity, storage), steps_executed() {
         steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) + ")");
     }
 
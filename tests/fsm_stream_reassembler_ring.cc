@@ -0,0 +1,152 @@
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+static constexpr auto RING = StreamReassembler::Storage::Ring;
+
+static constexpr unsigned NREPS = 32;
+static constexpr unsigned NSEGS = 128;
+static constexpr unsigned MAX_SEG_LEN = 2048;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            ReassemblerTestHarness test{65000, RING};
+
+            test.execute(SubmitSegment{"b", 1}.with_eof(true));
+            test.execute(SubmitSegment{"d", 3});
+
+            test.execute(BytesAssembled(0));
+            test.execute(UnassembledBytes(2));
+            test.execute(NotAtEof{});
+
+            test.execute(SubmitSegment{"abc", 0});
+
+            test.execute(BytesAssembled(4));
+            test.execute(BytesAvailable("abcd"));
+            test.execute(UnassembledBytes(0));
+            test.execute(AtEof{});
+        }
+
+        {
+            ReassemblerTestHarness test{65000, RING};
+
+            test.execute(SubmitSegment{"bcd", 1});
+            test.execute(SubmitSegment{"cdef", 2});
+            test.execute(SubmitSegment{"c", 2});
+
+            test.execute(BytesAssembled(0));
+            test.execute(UnassembledBytes(5));
+
+            test.execute(SubmitSegment{"ab", 0});
+
+            test.execute(BytesAssembled(6));
+            test.execute(BytesAvailable("abcdef"));
+            test.execute(UnassembledBytes(0));
+            test.execute(NotAtEof{});
+        }
+
+        // capacity smaller than a bitmap word, and data that wraps around the ring
+        {
+            ReassemblerTestHarness test{3, RING};
+
+            test.execute(SubmitSegment{"ab", 0});
+            test.execute(BytesAvailable("ab"));
+            test.execute(SubmitSegment{"de", 3});
+            test.execute(UnassembledBytes(2));
+            test.execute(SubmitSegment{"cd", 2});
+            test.execute(BytesAssembled(5));
+            test.execute(BytesAvailable("cde"));
+            test.execute(SubmitSegment{"fgh", 5}.with_eof(true));
+            test.execute(BytesAvailable("fgh"));
+            test.execute(AtEof{});
+        }
+
+        // growing and shrinking keeps what is stored, with either storage
+        for (const auto storage : {RING, StreamReassembler::Storage::Segments}) {
+            ReassemblerTestHarness test{100, storage};
+
+            test.execute(SubmitSegment{"xyz", 90});
+            test.execute(SubmitSegment{"ab", 0});
+            test.execute(BytesAvailable("ab"));
+            test.execute(SubmitSegment{"beyond", 102});
+            test.execute(UnassembledBytes(3));
+
+            test.execute(Resize{300});
+            test.execute(UnassembledBytes(3));
+            test.execute(SubmitSegment{"q", 200});
+            test.execute(SubmitSegment{string(88, 'c'), 2});
+            test.execute(BytesAssembled(93));
+            test.execute(BytesAvailable(string(88, 'c') + "xyz"));
+            test.execute(UnassembledBytes(1));
+
+            // no smaller than what is held: "q" stays acceptable
+            test.execute(Resize{10});
+            test.execute(UnassembledBytes(1));
+            test.execute(SubmitSegment{string(107, 'd'), 93});
+            test.execute(SubmitSegment{"r", 201}.with_eof(true));
+            test.execute(BytesAssembled(201));
+            test.execute(BytesAvailable(string(107, 'd') + "q"));
+            test.execute(NotAtEof{});
+            test.execute(SubmitSegment{"r", 201}.with_eof(true));
+            test.execute(BytesAvailable("r"));
+            test.execute(AtEof{});
+        }
+
+        // shuffled, overlapping segments across bitmap words must match the segment-set storage
+        for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+            StreamReassembler ring{MAX_SEG_LEN * NSEGS, RING};
+            StreamReassembler segments{MAX_SEG_LEN * NSEGS};
+
+            vector<tuple<size_t, size_t>> seq_size;
+            size_t offset = 0;
+            for (unsigned i = 0; i < NSEGS; ++i) {
+                const size_t size = 1 + (rd() % (MAX_SEG_LEN - 1));
+                const size_t overlap = min(offset, size_t{rd() % 64});
+                seq_size.emplace_back(offset - overlap, size + overlap);
+                offset += size;
+            }
+            shuffle(seq_size.begin(), seq_size.end(), rd);
+
+            string d(offset, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+
+            for (auto [off, sz] : seq_size) {
+                const string dd(d.cbegin() + off, d.cbegin() + off + sz);
+                ring.push_substring(dd, off, off + sz == offset);
+                segments.push_substring(dd, off, off + sz == offset);
+                if (ring.unassembled_bytes() != segments.unassembled_bytes()) {
+                    throw runtime_error("ring storage disagrees about the number of unassembled bytes");
+                }
+            }
+
+            const auto result = ring.stream_out().read(ring.stream_out().buffer_size());
+            if (result != d) {
+                throw runtime_error("ring storage reassembled the wrong bytes");
+            }
+            if (not ring.stream_out().eof()) {
+                throw runtime_error("ring storage did not reach EOF");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.timestamps = true;
+
+        // test 1: negotiate timestamps, echo the peer's, and drop segments with stale ones (PAWS)
+        {
+            const WrappingInt32 isn(rd());
+            const uint32_t ts_base = rd();
+            TCPTestHarness test_1(cfg);
+            test_1.execute(Listen{});
+            test_1.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_timestamp(ts_base, 0));
+
+            const TCPSegment syn_ack = test_1.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(isn + 1), "test 1 failed: SYN/ACK invalid");
+            test_err_if(not syn_ack.header().timestamp.has_value() or syn_ack.header().timestamp->echo != ts_base,
+                        "test 1 failed: SYN/ACK should echo the SYN's timestamp");
+            const WrappingInt32 ack_base = syn_ack.header().seqno;
+
+            test_1.execute(Tick(5));
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(isn + 1)
+                               .with_ackno(ack_base + 1)
+                               .with_win(1000)
+                               .with_timestamp(ts_base + 10, syn_ack.header().timestamp->value));
+            test_1.execute(ExpectState{State::ESTABLISHED});
+
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(isn + 1)
+                               .with_ackno(ack_base + 1)
+                               .with_win(1000)
+                               .with_data("abc")
+                               .with_timestamp(ts_base + 20, 0));
+            TCPSegment ack = test_1.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 4),
+                                               "test 1 failed: no ACK for data");
+            test_err_if(not ack.header().timestamp.has_value() or ack.header().timestamp->echo != ts_base + 20,
+                        "test 1 failed: ACK should echo the data's timestamp");
+            test_err_if(ack.header().timestamp->value != 5, "test 1 failed: ACK should carry the local clock");
+            test_1.execute(ExpectData{}.with_data("abc"));
+
+            // an older timestamp marks an old duplicate: it is acknowledged but not accepted
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(isn + 4)
+                               .with_ackno(ack_base + 1)
+                               .with_win(1000)
+                               .with_data("def")
+                               .with_timestamp(ts_base + 15, 0));
+            ack = test_1.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 4),
+                                    "test 1 failed: stale segment should be acknowledged but not accepted");
+            test_err_if(ack.header().timestamp->echo != ts_base + 20, "test 1 failed: stale timestamp was recorded");
+            test_1.execute(ExpectNoData{});
+
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(isn + 4)
+                               .with_ackno(ack_base + 1)
+                               .with_win(1000)
+                               .with_data("def")
+                               .with_timestamp(ts_base + 30, 0));
+            test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 7));
+            test_1.execute(ExpectData{}.with_data("def"));
+        }
+
+        // test 2: without the peer's agreement, no segment carries timestamps
+        {
+            const WrappingInt32 isn(rd());
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Listen{});
+            test_2.execute(SendSegment{}.with_syn(true).with_seqno(isn));
+            const TCPSegment syn_ack = test_2.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                         "test 2 failed: SYN/ACK invalid");
+            test_err_if(syn_ack.header().timestamp.has_value(), "test 2 failed: SYN/ACK shouldn't carry timestamps");
+        }
+
+        // test 3: a later SYN without the option doesn't turn timestamps (or PAWS) off
+        {
+            const WrappingInt32 isn(rd());
+            const uint32_t ts_base = rd();
+            TCPTestHarness test_3(cfg);
+            test_3.execute(Listen{});
+            test_3.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_timestamp(ts_base, 0));
+            const TCPSegment syn_ack = test_3.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                         "test 3 failed: SYN/ACK invalid");
+            const WrappingInt32 ack_base = syn_ack.header().seqno;
+            test_3.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(isn + 1)
+                               .with_ackno(ack_base + 1)
+                               .with_win(1000)
+                               .with_timestamp(ts_base + 10, syn_ack.header().timestamp->value));
+            test_3.execute(ExpectState{State::ESTABLISHED});
+
+            test_3.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_win(1000));
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 1));
+
+            // the old timestamp is still caught by PAWS
+            test_3.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(isn + 1)
+                               .with_ackno(ack_base + 1)
+                               .with_win(1000)
+                               .with_data("abc")
+                               .with_timestamp(ts_base + 5, 0));
+            TCPSegment ack = test_3.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 1),
+                                               "test 3 failed: stale segment should be acknowledged but not accepted");
+            test_err_if(not ack.header().timestamp.has_value() or ack.header().timestamp->echo != ts_base + 10,
+                        "test 3 failed: ACK should still carry timestamps");
+            test_3.execute(ExpectNoData{});
+
+            test_3.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(isn + 1)
+                               .with_ackno(ack_base + 1)
+                               .with_win(1000)
+                               .with_data("abc")
+                               .with_timestamp(ts_base + 20, 0));
+            ack = test_3.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(isn + 4),
+                                    "test 3 failed: no ACK for data");
+            test_3.execute(ExpectData{}.with_data("abc"));
+            test_err_if(not ack.header().timestamp.has_value() or ack.header().timestamp->echo != ts_base + 20,
+                        "test 3 failed: ACK should still echo the data's timestamp");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+static constexpr size_t RECV_CAPACITY = 1'000'000;  // needs a shift of 4 to fit in 16 bits
+static constexpr uint8_t OUR_SHIFT = 4;
+static constexpr uint16_t MAX_WIN = 65535;
+
+// Drain the segments sent so far, checking the window each advertises; returns the payload bytes
+size_t read_data_segments(TCPTestHarness &test, const WrappingInt32 ackno, const uint16_t win) {
+    size_t bytes_read = 0;
+    while (test.can_read()) {
+        const TCPSegment seg = test.expect_seg(ExpectSegment{}.with_ack(true).with_ackno(ackno).with_win(win),
+                                               "invalid segment carrying write() data");
+        bytes_read += seg.payload().size();
+    }
+    return bytes_read;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.window_scaling = true;
+        cfg.recv_capacity = RECV_CAPACITY;
+        cfg.send_capacity = 100'000;
+
+        // test 1: both sides offer window scaling, so windows past the SYNs are scaled both ways
+        {
+            const WrappingInt32 isn(rd());
+            TCPTestHarness test_1(cfg);
+            test_1.execute(Listen{});
+            test_1.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_win(100).with_window_scale(7));
+
+            // the SYN/ACK's own window is never scaled
+            const TCPSegment syn_ack = test_1.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(isn + 1).with_win(MAX_WIN),
+                "test 1 failed: SYN/ACK invalid");
+            test_err_if(syn_ack.header().window_scale != optional<uint8_t>{OUR_SHIFT},
+                        "test 1 failed: SYN/ACK should offer a shift that fits the receive capacity");
+            const WrappingInt32 ack_base = syn_ack.header().seqno;
+
+            // 400 << 7 bytes of window
+            test_1.send_ack(isn + 1, ack_base + 1, 400);
+            test_1.execute(ExpectState{State::ESTABLISHED});
+            test_1.execute(Write{string(100'000, 'x')}.with_bytes_written(100'000));
+            test_1.execute(Tick(1));
+            const size_t bytes_read = read_data_segments(test_1, isn + 1, RECV_CAPACITY >> OUR_SHIFT);
+            test_err_if(bytes_read != 400 << 7, "test 1 failed: sender should fill the scaled window");
+            test_1.execute(ExpectBytesInFlight{400 << 7});
+        }
+
+        // test 2: the peer doesn't offer window scaling, so neither side scales
+        {
+            const WrappingInt32 isn(rd());
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Listen{});
+            test_2.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_win(100));
+
+            const TCPSegment syn_ack = test_2.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(isn + 1).with_win(MAX_WIN),
+                "test 2 failed: SYN/ACK invalid");
+            test_err_if(syn_ack.header().window_scale.has_value(),
+                        "test 2 failed: SYN/ACK shouldn't offer window scaling unless the SYN did");
+            const WrappingInt32 ack_base = syn_ack.header().seqno;
+
+            test_2.send_ack(isn + 1, ack_base + 1, 4000);
+            test_2.execute(Write{string(10'000, 'x')}.with_bytes_written(10'000));
+            test_2.execute(Tick(1));
+            const size_t bytes_read = read_data_segments(test_2, isn + 1, MAX_WIN);
+            test_err_if(bytes_read != 4000, "test 2 failed: the window should not be scaled");
+        }
+
+        // test 3: an active opener offers window scaling on its SYN only if configured to
+        {
+            TCPTestHarness test_3(cfg);
+            test_3.execute(Connect{});
+            const TCPSegment syn = test_3.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(false).with_win(MAX_WIN), "test 3 failed: SYN invalid");
+            test_err_if(syn.header().window_scale != optional<uint8_t>{OUR_SHIFT},
+                        "test 3 failed: SYN should offer window scaling");
+
+            TCPTestHarness test_4(TCPConfig{});
+            test_4.execute(Connect{});
+            const TCPSegment plain_syn =
+                test_4.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(false), "test 3 failed: SYN invalid");
+            test_err_if(plain_syn.header().window_scale.has_value(),
+                        "test 3 failed: SYN shouldn't offer window scaling by default");
+        }
+
+        // test 4: a later SYN without the option doesn't turn window scaling off
+        {
+            const WrappingInt32 isn(rd());
+            TCPTestHarness test_4(cfg);
+            test_4.execute(Listen{});
+            test_4.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_win(100).with_window_scale(7));
+            const TCPSegment syn_ack = test_4.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                         "test 4 failed: SYN/ACK invalid");
+            test_4.send_ack(isn + 1, syn_ack.header().seqno + 1, 400);
+            test_4.execute(ExpectState{State::ESTABLISHED});
+
+            test_4.execute(SendSegment{}.with_syn(true).with_seqno(isn).with_win(100));
+            test_4.execute(Write{string(100'000, 'x')}.with_bytes_written(100'000));
+            test_4.execute(Tick(1));
+            const size_t bytes_read = read_data_segments(test_4, isn + 1, RECV_CAPACITY >> OUR_SHIFT);
+            test_err_if(bytes_read != 400 << 7, "test 4 failed: the peer's window should still be scaled");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
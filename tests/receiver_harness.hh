@@ -13,6 +13,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 struct ReceiverTestStep {
     virtual std::string to_string() const { return "ReceiverTestStep"; }
@@ -100,6 +101,34 @@ struct ExpectUnassembledBytes : public ReceiverExpectation {
     }
 };
 
+struct ExpectSackBlocks : public ReceiverExpectation {
+    std::vector<SackBlock> _blocks;
+    size_t _max_blocks;
+
+    ExpectSackBlocks(std::vector<SackBlock> blocks, size_t max_blocks = TCPHeader::MAX_SACK_BLOCKS)
+        : _blocks(std::move(blocks)), _max_blocks(max_blocks) {}
+
+    static std::string blocks_string(const std::vector<SackBlock> &blocks) {
+        std::ostringstream ss;
+        ss << "[";
+        for (const auto &block : blocks) {
+            ss << " " << block.begin << "-" << block.end;
+        }
+        ss << " ]";
+        return ss.str();
+    }
+
+    std::string description() const { return "SACK blocks " + blocks_string(_blocks); }
+
+    void execute(TCPReceiver &receiver) const {
+        const auto blocks = receiver.sack_blocks(_max_blocks);
+        if (blocks != _blocks) {
+            throw ReceiverExpectationViolation("The TCPReceiver reported SACK blocks `" + blocks_string(blocks) +
+                                               "`, but they were expected to be `" + blocks_string(_blocks) + "`");
+        }
+    }
+};
+
 struct ExpectTotalAssembledBytes : public ReceiverExpectation {
     size_t _n_bytes;
 
@@ -298,10 +327,11 @@ class TCPReceiverTestHarness {
     std::vector<std::string> steps_executed;
 
   public:
-    TCPReceiverTestHarness(size_t capacity) : receiver(capacity), steps_executed() {
+    TCPReceiverTestHarness(size_t capacity, StreamReassembler::Storage storage = StreamReassembler::Storage::Segments)
+        : receiver(capacity, storage), steps_executed() {
         std::ostringstream ss;
         ss << "Initialized with ("
-           << "capacity=" << capacity << ")";
+           << "capacity=" << capacity << (storage == StreamReassembler::Storage::Ring ? ", ring" : "") << ")";
         steps_executed.emplace_back(ss.str());
     }
     void execute(const ReceiverTestStep &step) {
@@ -0,0 +1,74 @@
+#include "receiver_harness.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (const auto storage : {StreamReassembler::Storage::Segments, StreamReassembler::Storage::Ring}) {
+            // Blocks report the runs held beyond the ackno, the latest first
+            {
+                uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+                TCPReceiverTestHarness test{4000, storage};
+                test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+                test.execute(ExpectSackBlocks{{}});
+                test.execute(SegmentArrives{}.with_seqno(isn + 3).with_data("cd"));
+                test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 3}, WrappingInt32{isn + 5}}}});
+                test.execute(SegmentArrives{}.with_seqno(isn + 7).with_data("gh"));
+                test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 7}, WrappingInt32{isn + 9}},
+                                               {WrappingInt32{isn + 3}, WrappingInt32{isn + 5}}}});
+                // filling the gap between them merges the two blocks
+                test.execute(SegmentArrives{}.with_seqno(isn + 5).with_data("ef"));
+                test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 3}, WrappingInt32{isn + 9}}}});
+                test.execute(ExpectAckno{WrappingInt32{isn + 1}});
+                test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("ab"));
+                test.execute(ExpectAckno{WrappingInt32{isn + 9}});
+                test.execute(ExpectSackBlocks{{}});
+                test.execute(ExpectBytes{"abcdefgh"});
+            }
+
+            // Only the most recent block jumps the queue; the rest are in order and capped
+            {
+                uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+                TCPReceiverTestHarness test{4000, storage};
+                test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+                for (const uint32_t offset : {3, 5, 9, 11, 7}) {
+                    test.execute(SegmentArrives{}.with_seqno(isn + offset).with_data("x"));
+                }
+                test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 7}, WrappingInt32{isn + 8}},
+                                               {WrappingInt32{isn + 3}, WrappingInt32{isn + 4}},
+                                               {WrappingInt32{isn + 5}, WrappingInt32{isn + 6}},
+                                               {WrappingInt32{isn + 9}, WrappingInt32{isn + 10}}}});
+                test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 7}, WrappingInt32{isn + 8}},
+                                               {WrappingInt32{isn + 3}, WrappingInt32{isn + 4}}},
+                                              2});
+                test.execute(ExpectUnassembledBytes{5});
+            }
+
+            // A block spanning a bitmap word boundary is still one block
+            {
+                uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+                TCPReceiverTestHarness test{4000, storage};
+                test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+                test.execute(SegmentArrives{}.with_seqno(isn + 61).with_data(string(100, 'y')));
+                test.execute(SegmentArrives{}.with_seqno(isn + 161).with_data(string(100, 'z')));
+                test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 61}, WrappingInt32{isn + 261}}}});
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+#include "congestion_controller.hh"
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::NewReno;
+
+            TCPSenderTestHarness test{"NewReno starts with a ten-segment window and slow-starts", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(30 * mss, 'x')});
+            for (unsigned i = 0; i < 10; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{10 * mss});
+
+            // each ACK of a full segment grows cwnd by one segment, so two more go out
+            test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 10 * mss));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 11 * mss));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::NewReno;
+
+            TCPSenderTestHarness test{"NewReno fast-retransmits on the third duplicate ACK", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(30 * mss, 'x')});
+            for (unsigned i = 0; i < 10; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(mss));
+            }
+            test.execute(ExpectNoSegment{});
+
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+            // cwnd is now ssthresh + 3 segments = 8 segments, below the 10 in flight
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{10 * mss});
+
+            // duplicates during recovery inflate the window until new data can be sent
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + 10 * mss));
+            test.execute(ExpectNoSegment{});
+
+            // a full ACK ends recovery, deflating cwnd to min(ssthresh, flight size + one segment)
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 11 * mss}}.with_win(60000));
+            for (unsigned i = 0; i < 2; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1 + (11 + i) * mss));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::NewReno;
+
+            TCPSenderTestHarness test{"NewReno collapses to one segment on timeout", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(30 * mss, 'x')});
+            for (unsigned i = 0; i < 10; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(mss));
+            }
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+
+            // cwnd restarts from one segment, and 9 segments are still in flight
+            test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::NewReno;
+
+            TCPSenderTestHarness test{"NewReno doesn't fast-retransmit for losses a timeout already covers", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(30 * mss, 'x')});
+            for (unsigned i = 0; i < 10; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(mss));
+            }
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+            test.execute(ExpectNoSegment{});
+
+            // duplicates of an ACK below what was sent before the timeout start no recovery
+            for (unsigned i = 0; i < TCPConfig::DUP_ACK_THRESHOLD; ++i) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + mss}}.with_win(60000));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{9 * mss});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::Bbr;
+
+            TCPSenderTestHarness test{"BBR paces once it has measured the path", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            // nothing measured yet beyond the handshake: the initial window goes out at once
+            test.execute(WriteBytes{string(30 * mss, 'x')});
+            for (unsigned i = 0; i < 10; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(mss));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // 5000 bytes in 10 ms: cwnd grows to 15 segments, but the rest leaves at the
+            // initial pacing rate of 2.885 * 10 segments per 10 ms, a little under 3 per ms
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 5 * mss}}.with_win(60000));
+            test.execute(ExpectNoSegment{});
+            for (unsigned ms = 0; ms < 2; ++ms) {
+                test.execute(Tick{1});
+                for (unsigned i = 0; i < 3; ++i) {
+                    test.execute(ExpectSegment{}.with_payload_size(mss));
+                }
+                test.execute(ExpectNoSegment{});
+            }
+            test.execute(Tick{1});
+            for (unsigned i = 0; i < 3; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(mss));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{14 * mss});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(mss));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            // drive the model directly: 10 segments acknowledged every 10 ms round trip
+            Bbr bbr{mss};
+            const auto expect_mode = [&](const Bbr::Mode mode, const string &when) {
+                if (bbr.mode() != mode) {
+                    throw runtime_error("BBR is in the wrong mode " + when);
+                }
+            };
+
+            uint64_t delivered = 0;
+            const auto round = [&](const uint64_t bytes_in_flight) {
+                bbr.tick(10);
+                RateSample sample;
+                sample.prior_delivered = delivered;
+                delivered += 10 * mss;
+                sample.delivered = 10 * mss;
+                sample.total_delivered = delivered;
+                sample.interval_ms = 10;
+                sample.rtt_ms = 10;
+                bbr.on_rate_sample(sample);
+                bbr.on_ack(delivered, 10 * mss, bytes_in_flight);
+            };
+
+            round(10 * mss);
+            expect_mode(Bbr::Mode::Startup, "after the first round");
+            for (unsigned i = 0; i < 2; ++i) {
+                round(10 * mss);
+            }
+            expect_mode(Bbr::Mode::Startup, "before the bandwidth has stopped growing for three rounds");
+            round(30 * mss);
+            expect_mode(Bbr::Mode::Drain, "once the bandwidth has stopped growing");
+            if (bbr.pacing_rate() >= bbr.bottleneck_bandwidth()) {
+                throw runtime_error("BBR doesn't pace below the bottleneck bandwidth to drain the queue");
+            }
+            round(10 * mss);
+            expect_mode(Bbr::Mode::ProbeBw, "once the queue has drained");
+
+            // after 10 s without a lower RTT, the flight shrinks to four segments to measure it again
+            bbr.tick(Bbr::MIN_RTT_WINDOW_MS);
+            round(10 * mss);
+            expect_mode(Bbr::Mode::ProbeRtt, "when the min RTT is stale");
+            if (bbr.cwnd() != Bbr::MIN_CWND_SEGMENTS * mss) {
+                throw runtime_error("BBR doesn't shrink cwnd in ProbeRtt");
+            }
+            round(4 * mss);
+            bbr.tick(Bbr::PROBE_RTT_MS);
+            round(4 * mss);
+            expect_mode(Bbr::Mode::ProbeBw, "after ProbeRtt");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -422,6 +422,9 @@ int main() {
             test.execute(AckReceived{WrappingInt32{isn + 8}}.with_win(1000));
             test.execute(AckReceived{WrappingInt32{isn + 8}}.with_win(1000));
             test.execute(AckReceived{WrappingInt32{isn + 8}}.with_win(1000));
+            // ... except that the third duplicate of an ACK with data outstanding triggers a fast retransmit
+            test.execute(ExpectSegment{}.with_payload_size(4).with_data("ijkl").with_seqno(isn + 8).with_fin(true));
+            test.execute(ExpectNoSegment{});
             test.execute(AckReceived{WrappingInt32{isn + 12}}.with_win(1000));
             test.execute(AckReceived{WrappingInt32{isn + 12}}.with_win(1000));
             test.execute(AckReceived{WrappingInt32{isn + 12}}.with_win(1000));
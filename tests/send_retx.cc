@@ -105,6 +105,99 @@ int main() {
             test.execute(Tick{1}.with_max_retx_exceeded(true));
         }
 
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            uint16_t retx_timeout = uniform_int_distribution<uint16_t>{10, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = retx_timeout;
+
+            TCPSenderTestHarness test{"Fast retransmit on the third duplicate ACK", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(4));
+            test.execute(WriteBytes{"abcdefgh"});
+            test.execute(ExpectSegment{}.with_data("abcd"));
+            test.execute(AckReceived{WrappingInt32{isn + 3}}.with_win(4));
+            test.execute(ExpectSegment{}.with_data("ef"));
+            test.execute(AckReceived{WrappingInt32{isn + 3}}.with_win(4));
+            test.execute(AckReceived{WrappingInt32{isn + 3}}.with_win(4));
+            test.execute(ExpectNoSegment{});
+            // a different window makes an ACK a window update, not a duplicate
+            test.execute(AckReceived{WrappingInt32{isn + 3}}.with_win(5));
+            test.execute(ExpectSegment{}.with_data("g"));
+            test.execute(AckReceived{WrappingInt32{isn + 3}}.with_win(5));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 3}}.with_win(5));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 3}}.with_win(5));
+            // the earliest outstanding segment goes again whole
+            test.execute(ExpectSegment{}.with_data("abcd").with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 3}}.with_win(5));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{7});
+            test.execute(Tick{retx_timeout - 1u}.with_max_retx_exceeded(false));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            uint16_t retx_timeout = uniform_int_distribution<uint16_t>{10, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = retx_timeout;
+            cfg.retransmit_collapse = true;
+
+            TCPSenderTestHarness test{"Small segments are retransmitted merged, up to one MSS", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(5000));
+            test.execute(WriteBytes{"a"});
+            test.execute(WriteBytes{"bc"});
+            test.execute(WriteBytes{string(TCPConfig::MAX_PAYLOAD_SIZE - 3, 'd')});
+            test.execute(WriteBytes{"e"});
+            test.execute(ExpectSegment{}.with_data("a"));
+            test.execute(ExpectSegment{}.with_data("bc"));
+            test.execute(ExpectSegment{}.with_payload_size(TCPConfig::MAX_PAYLOAD_SIZE - 3));
+            test.execute(ExpectSegment{}.with_data("e"));
+            test.execute(Tick{retx_timeout});
+            test.execute(ExpectSegment{}
+                             .with_data("abc" + string(TCPConfig::MAX_PAYLOAD_SIZE - 3, 'd'))
+                             .with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{TCPConfig::MAX_PAYLOAD_SIZE + 1});
+
+            // then with a FIN, which joins the data before it
+            test.execute(AckReceived{WrappingInt32{isn + 1 + TCPConfig::MAX_PAYLOAD_SIZE}}.with_win(5000));
+            test.execute(WriteBytes{"f"}.with_end_input(true));
+            test.execute(ExpectSegment{}.with_data("f").with_fin(true));
+            test.execute(Tick{retx_timeout});
+            test.execute(
+                ExpectSegment{}.with_data("ef").with_fin(true).with_seqno(isn + 1 + TCPConfig::MAX_PAYLOAD_SIZE));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            uint16_t retx_timeout = uniform_int_distribution<uint16_t>{10, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = retx_timeout;
+            cfg.retransmit_collapse = true;
+
+            TCPSenderTestHarness test{"Merged retransmissions stay within the window", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(3));
+            test.execute(WriteBytes{"a"});
+            test.execute(WriteBytes{"b"});
+            test.execute(WriteBytes{"c"});
+            test.execute(ExpectSegment{}.with_data("a"));
+            test.execute(ExpectSegment{}.with_data("b"));
+            test.execute(ExpectSegment{}.with_data("c"));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(2));
+            test.execute(Tick{retx_timeout});
+            test.execute(ExpectSegment{}.with_data("ab").with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+        }
+
     } catch (const exception &e) {
         cerr << e.what() << endl;
         return 1;
@@ -0,0 +1,138 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rtt_estimation = true;
+
+            TCPSenderTestHarness test{"RTO follows SRTT + 4 * RTTVAR after the first sample", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            // the SYN is acknowledged after 100 ms: SRTT = 100, RTTVAR = 50, RTO = 300
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{299});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            // backed off to 600 ms
+            test.execute(Tick{599});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc"));
+
+            // Karn's rule: the ACK of a retransmitted segment gives no sample, and the backed-off RTO stays
+            test.execute(Tick{20});
+            test.execute(AckReceived{WrappingInt32{isn + 4}});
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def"));
+            test.execute(Tick{1199});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("def"));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rtt_estimation = true;
+
+            TCPSenderTestHarness test{"A steady RTT shrinks RTTVAR and the RTO with it", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            // a second 100 ms sample: RTTVAR = 3/4 * 50, so RTO = 100 + 150 = 250
+            test.execute(WriteBytes{"a"});
+            test.execute(ExpectSegment{}.with_data("a"));
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 2}});
+            test.execute(WriteBytes{"b"});
+            test.execute(ExpectSegment{}.with_data("b"));
+            test.execute(Tick{249});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("b"));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rtt_estimation = true;
+            cfg.min_rto = 50;
+            cfg.max_rto = 150;
+
+            TCPSenderTestHarness test{"The estimated and backed-off RTO stay within bounds", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            // a 2 ms RTT on its own would give a 6 ms RTO
+            test.execute(Tick{2});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{49});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{99});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{149});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{149});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc"));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rtt_estimation = true;
+
+            TCPSenderTestHarness test{"Echoed timestamps give RTT samples from retransmissions too", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_timestamp_echo(0));
+            // SRTT = 100, RTTVAR = 50, RTO = 300
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{300});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            // the ACK echoes the retransmission's timestamp (400): a 50 ms sample, which Karn's rule would discard
+            test.execute(Tick{50});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_timestamp_echo(400));
+            // RTTVAR = 3/4 * 50 + 1/4 * 50 = 50, SRTT = 7/8 * 100 + 1/8 * 50 = 93.75, RTO = ceil(293.75)
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def"));
+            test.execute(Tick{293});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("def"));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            uint16_t retx_timeout = uniform_int_distribution<uint16_t>{10, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = retx_timeout;
+
+            TCPSenderTestHarness test{"SACK repairs a second hole without waiting for a timeout", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            for (const string data : {"aaaa", "bbbb", "cccc", "dddd", "eeee", "ffff"}) {
+                test.execute(WriteBytes{string(data)});
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            // "aaaa" and "cccc" are lost
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_sack(isn + 5, isn + 9));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_sack(isn + 5, isn + 9).with_sack(isn + 13, isn + 17));
+            test.execute(ExpectNoSegment{});
+            // third duplicate: the earliest segment goes again, but only two segments are SACKed above "cccc"
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_sack(isn + 5, isn + 9).with_sack(isn + 13, isn + 21));
+            test.execute(ExpectSegment{}.with_data("aaaa").with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_sack(isn + 5, isn + 9).with_sack(isn + 13, isn + 25));
+            test.execute(ExpectSegment{}.with_data("cccc").with_seqno(isn + 9));
+            test.execute(ExpectNoSegment{});
+            // repaired segments aren't sent again on later ACKs...
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_sack(isn + 5, isn + 9).with_sack(isn + 13, isn + 25));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{24});
+            // ...until a timeout, after which the scoreboard may resend them
+            test.execute(Tick{retx_timeout});
+            test.execute(ExpectSegment{}.with_data("aaaa").with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_sack(isn + 5, isn + 9).with_sack(isn + 13, isn + 25));
+            test.execute(ExpectSegment{}.with_data("cccc").with_seqno(isn + 9));
+            test.execute(AckReceived{WrappingInt32{isn + 25}});
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"SACK blocks outside the outstanding data are ignored", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            for (const string data : {"aaaa", "bbbb", "cccc", "dddd"}) {
+                test.execute(WriteBytes{string(data)});
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            // accepted, either block would mark three segments above "aaaa" as SACKed
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_sack(isn + 5, isn + 30));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_sack(isn + 17, isn + 5));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{16});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = TCPConfig::CongestionControl::NewReno;
+            const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+            const auto seg = [&isn, mss](const unsigned i) { return isn + 1 + i * mss; };
+
+            TCPSenderTestHarness test{"SACK losses halve the window, and go out as the pipe drains", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(10 * mss, 'x')});
+            for (unsigned i = 0; i < 10; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(seg(i)));
+            }
+            // the first four segments are lost
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000).with_sack(seg(4), seg(5)));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000).with_sack(seg(4), seg(6)));
+            test.execute(ExpectNoSegment{});
+            // cwnd drops to 5 segments; 3 SACKed and 4 lost leave 3 in the pipe, so only 2 go out
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000).with_sack(seg(4), seg(7)));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(seg(0)));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(seg(1)));
+            test.execute(ExpectNoSegment{});
+            // each further SACKed segment makes room for one more
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000).with_sack(seg(4), seg(8)));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(seg(2)));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000).with_sack(seg(4), seg(9)));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(seg(3)));
+            test.execute(ExpectNoSegment{});
+            // the full ACK ends recovery, with cwnd within the halved ssthresh
+            test.execute(WriteBytes{string(10 * mss, 'y')});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{seg(10)}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(seg(10)));
+            test.execute(ExpectSegment{}.with_payload_size(mss).with_seqno(seg(11)));
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
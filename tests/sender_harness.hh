@@ -15,6 +15,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
 
@@ -191,11 +192,19 @@ struct Tick : public SenderAction {
 struct AckReceived : public SenderAction {
     WrappingInt32 _ackno;
     std::optional<uint16_t> _window_advertisement{};
+    std::vector<SackBlock> _sack_blocks{};
+    std::optional<uint32_t> _timestamp_echo{};
 
     AckReceived(WrappingInt32 ackno) : _ackno(ackno) {}
     std::string description() const {
         std::ostringstream ss;
         ss << "ack " << _ackno.raw_value() << " winsize " << _window_advertisement.value_or(DEFAULT_TEST_WINDOW);
+        for (const auto &block : _sack_blocks) {
+            ss << " sack " << block.begin << "-" << block.end;
+        }
+        if (_timestamp_echo.has_value()) {
+            ss << " echoing timestamp " << _timestamp_echo.value();
+        }
         return ss.str();
     }
 
@@ -204,8 +213,19 @@ struct AckReceived : public SenderAction {
         return *this;
     }
 
+    AckReceived &with_sack(WrappingInt32 begin, WrappingInt32 end) {
+        _sack_blocks.push_back({begin, end});
+        return *this;
+    }
+
+    AckReceived &with_timestamp_echo(uint32_t echo) {
+        _timestamp_echo.emplace(echo);
+        return *this;
+    }
+
     void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
-        sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW));
+        sender.ack_received(
+            _ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW), true, _sack_blocks, _timestamp_echo);
         sender.fill_window();
     }
 };
@@ -394,7 +414,7 @@ class TCPSenderTestHarness {
   public:
     TCPSenderTestHarness(const std::string &name_, TCPConfig config)
         : outbound_segments()
-        , sender(config.send_capacity, config.rt_timeout, config.fixed_isn)
+        , sender(config)
         , steps_executed()
         , name(name_) {
         sender.fill_window();
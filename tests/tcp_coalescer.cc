@@ -0,0 +1,106 @@
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "tcp_segment_coalescer.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+TCPSegment data_segment(const WrappingInt32 seqno, const WrappingInt32 ackno, const string &data) {
+    TCPSegment seg;
+    seg.header().ack = true;
+    seg.header().seqno = seqno;
+    seg.header().ackno = ackno;
+    seg.header().win = 1000;
+    seg.payload() = string(data);
+    return seg;
+}
+
+vector<TCPSegment> drain(TCPSegmentCoalescer &coalescer) {
+    coalescer.flush();
+    vector<TCPSegment> ret;
+    for (; not coalescer.segments_out().empty(); coalescer.segments_out().pop()) {
+        ret.push_back(move(coalescer.segments_out().front()));
+    }
+    return ret;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const WrappingInt32 seqno{static_cast<uint32_t>(rd())};
+        const WrappingInt32 ackno{static_cast<uint32_t>(rd())};
+
+        // In-order segments are merged, and a FIN ends the merged segment
+        {
+            TCPSegmentCoalescer coalescer;
+            coalescer.push(data_segment(seqno, ackno, "abc"));
+            coalescer.push(data_segment(seqno + 3, ackno, "def"));
+            TCPSegment with_fin = data_segment(seqno + 6, ackno, "gh");
+            with_fin.header().fin = true;
+            coalescer.push(move(with_fin));
+            coalescer.push(data_segment(seqno + 9, ackno, "ij"));
+            test_err_if(coalescer.segments_out().size() != 1, "the FIN should end the merged segment");
+            const auto segs = drain(coalescer);
+            test_err_if(segs.size() != 2, "expected the merged segment and the one after the FIN");
+            test_err_if(segs[0].payload().str() != "abcdefgh", "wrong merged payload");
+            test_err_if(segs[0].header().seqno != seqno or not segs[0].header().fin,
+                        "merged segment should have the first's seqno and the FIN");
+            test_err_if(segs[1].payload().str() != "ij", "segment after the FIN should be left alone");
+        }
+
+        // A gap, a new ackno or new SACK information starts a new segment
+        {
+            TCPSegmentCoalescer coalescer;
+            coalescer.push(data_segment(seqno, ackno, "abc"));
+            coalescer.push(data_segment(seqno + 4, ackno, "efg"));
+            coalescer.push(data_segment(seqno + 7, ackno + 1, "hij"));
+            TCPSegment with_sack = data_segment(seqno + 10, ackno + 1, "klm");
+            with_sack.header().sack_blocks.push_back({ackno + 5, ackno + 6});
+            coalescer.push(move(with_sack));
+            test_err_if(drain(coalescer).size() != 4, "none of these segments should be merged");
+        }
+
+        // Segments without data, or with SYN or RST, pass through unmerged and in order
+        {
+            TCPSegmentCoalescer coalescer;
+            coalescer.push(data_segment(seqno, ackno, "abc"));
+            coalescer.push(data_segment(seqno + 3, ackno, ""));
+            TCPSegment rst = data_segment(seqno + 3, ackno, "def");
+            rst.header().rst = true;
+            coalescer.push(move(rst));
+            const auto segs = drain(coalescer);
+            test_err_if(segs.size() != 3, "expected three segments");
+            test_err_if(segs[0].payload().str() != "abc" or segs[1].payload().size() != 0 or not segs[2].header().rst,
+                        "segments out of order");
+        }
+
+        // Merged payloads are capped
+        {
+            TCPSegmentCoalescer coalescer;
+            const string chunk(1000, 'x');
+            const size_t count = TCPSegmentCoalescer::MAX_PAYLOAD / chunk.size() + 1;
+            for (size_t i = 0; i < count; i++) {
+                coalescer.push(data_segment(seqno + i * chunk.size(), ackno, chunk));
+            }
+            const auto segs = drain(coalescer);
+            test_err_if(segs.size() != 2, "expected the cap to split the run in two");
+            test_err_if(segs[0].payload().size() > TCPSegmentCoalescer::MAX_PAYLOAD, "merged segment too large");
+            test_err_if(segs[1].header().seqno != seqno + segs[0].payload().size(),
+                        "second segment should follow the first");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
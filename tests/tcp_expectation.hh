@@ -252,7 +252,7 @@ struct ExpectSegment : public TCPExpectation {
             throw SegmentExpectationViolation::violated_field(
                 "payload_size", payload_size.value(), seg.payload().size());
         }
-        if (seg.length_in_sequence_space() > TCPConfig::MAX_PAYLOAD_SIZE) {
+        if (seg.length_in_sequence_space() > harness._mss) {
             throw SegmentExpectationViolation("packet has length_including_flags (" +
                                               std::to_string(seg.length_in_sequence_space()) +
                                               ") greater than the maximum");
@@ -344,6 +344,32 @@ struct ExpectBytesInFlight : public TCPExpectation {
     }
 };
 
+struct ExpectNextTimer : public TCPExpectation {
+    std::optional<size_t> ms;
+
+    ExpectNextTimer(std::optional<size_t> ms_) : ms(ms_) {}
+
+    std::string description() const {
+        std::ostringstream o;
+        if (ms.has_value()) {
+            o << "TCP has a timer expiring in " << ms.value() << " ms";
+        } else {
+            o << "TCP has no timer running";
+        }
+        return o.str();
+    }
+
+    void execute(TCPTestHarness &harness) const {
+        const std::optional<size_t> actual_ms = harness._fsm.time_until_next_timer();
+        if (actual_ms != ms) {
+            const auto name = [](const std::optional<size_t> &t) {
+                return t.has_value() ? std::to_string(t.value()) + " ms" : std::string("none");
+            };
+            throw TCPPropertyViolation::make("time_until_next_timer", name(ms), name(actual_ms));
+        }
+    }
+};
+
 struct ExpectUnassembledBytes : public TCPExpectation {
     uint64_t bytes;
 
@@ -390,6 +416,9 @@ struct SendSegment : public TCPAction {
     WrappingInt32 seqno{0};
     WrappingInt32 ackno{0};
     uint16_t win{0};
+    std::optional<uint16_t> mss{};
+    std::optional<uint8_t> window_scale{};
+    std::optional<TCPTimestamp> timestamp{};
     size_t payload_size{0};
     std::string data{};
 
@@ -403,6 +432,9 @@ struct SendSegment : public TCPAction {
         seqno = seg.header().seqno;
         ackno = seg.header().ackno;
         win = seg.header().win;
+        mss = seg.header().mss;
+        window_scale = seg.header().window_scale;
+        timestamp = seg.header().timestamp;
         data = seg.payload();
     }
 
@@ -445,6 +477,21 @@ struct SendSegment : public TCPAction {
         return *this;
     }
 
+    SendSegment &with_mss(uint16_t mss_) {
+        mss = mss_;
+        return *this;
+    }
+
+    SendSegment &with_window_scale(uint8_t window_scale_) {
+        window_scale = window_scale_;
+        return *this;
+    }
+
+    SendSegment &with_timestamp(uint32_t value, uint32_t echo) {
+        timestamp = TCPTimestamp{value, echo};
+        return *this;
+    }
+
     SendSegment &with_payload_size(size_t payload_size_) {
         payload_size = payload_size_;
         return *this;
@@ -466,6 +513,9 @@ struct SendSegment : public TCPAction {
         data_hdr.ackno = ackno;
         data_hdr.seqno = seqno;
         data_hdr.win = win;
+        data_hdr.mss = mss;
+        data_hdr.window_scale = window_scale;
+        data_hdr.timestamp = timestamp;
         return data_seg;
     }
 
@@ -564,4 +614,13 @@ struct Close : public TCPAction {
     void execute(TCPTestHarness &harness) const { harness._fsm.end_input_stream(); }
 };
 
+struct SetCorked : public TCPAction {
+    bool corked;
+
+    SetCorked(bool corked_) : corked(corked_) {}
+
+    std::string description() const { return corked ? "cork" : "uncork"; }
+    void execute(TCPTestHarness &harness) const { harness._fsm.set_corked(corked); }
+};
+
 #endif  // SPONGE_LIBSPONGE_TCP_EXPECTATION_HH
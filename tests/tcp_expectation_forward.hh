@@ -29,6 +29,7 @@ struct ExpectData;
 struct ExpectNoData;
 struct ExpectSegmentAvailable;
 struct ExpectBytesInFlight;
+struct ExpectNextTimer;
 struct ExpectUnassembledBytes;
 struct ExpectWaitTimer;
 struct SendSegment;
@@ -37,6 +38,7 @@ struct Tick;
 struct Connect;
 struct Listen;
 struct Close;
+struct SetCorked;
 
 class TCPExpectationViolation : public std::runtime_error {
   public:
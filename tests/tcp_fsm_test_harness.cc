@@ -67,7 +67,13 @@ void TestFdAdapter::config_segment(TCPSegment &seg) {
 //! \param[in] seg is the TCPSegment to write
 void TestFdAdapter::write(TCPSegment &seg) {
     config_segment(seg);
-    TestFD::write(seg.serialize());
+    if (seg.gso_size() == 0) {
+        TestFD::write(seg.serialize());
+        return;
+    }
+    for (const auto &wire_seg : seg.wire_segments()) {
+        TestFD::write(wire_seg.serialize());
+    }
 }
 
 //! \param[in] seqno is the sequence number of the segment
@@ -105,12 +111,15 @@ void TCPTestHarness::send_rst(const WrappingInt32 seqno, const optional<Wrapping
 
 //! \param[in] seqno is the sequence number of the segment
 //! \param[in] ackno is the optional acknowledgment number of the segment; if no value, ACK flag is not set
-void TCPTestHarness::send_syn(const WrappingInt32 seqno, const optional<WrappingInt32> ackno) {
+//! \param[in] swin is the optional window size for the segment; if no value, uses default value (137 bytes)
+void TCPTestHarness::send_syn(const WrappingInt32 seqno,
+                              const optional<WrappingInt32> ackno,
+                              const optional<uint16_t> swin) {
     SendSegment step{};
     if (ackno.has_value()) {
         step.with_ack(true).with_ackno(ackno.value());
     }
-    step.with_syn(true).with_seqno(seqno).with_win(DEFAULT_TEST_WINDOW);
+    step.with_syn(true).with_seqno(seqno).with_win(swin.value_or(DEFAULT_TEST_WINDOW));
     execute(step);
 }
 
@@ -209,13 +218,15 @@ TCPTestHarness TCPTestHarness::in_syn_sent(const TCPConfig &cfg, const WrappingI
 //!            seqno for the SYN.
 //! \param[in] rx_isn is the ISN of the FSM's inbound sequence. i.e. the
 //!            seqno for the SYN.
+//! \param[in] swin is the window the peer advertises with its SYN
 TCPTestHarness TCPTestHarness::in_established(const TCPConfig &cfg,
                                               const WrappingInt32 tx_isn,
-                                              const WrappingInt32 rx_isn) {
+                                              const WrappingInt32 rx_isn,
+                                              const optional<uint16_t> swin) {
     TCPTestHarness h = in_syn_sent(cfg, tx_isn);
     // It has sent a SYN with nothing else, and that SYN has been consumed
     // We reply with ACK and SYN.
-    h.send_syn(rx_isn, tx_isn + 1);
+    h.send_syn(rx_isn, tx_isn + 1, swin);
     h.execute(ExpectOneSegment{}.with_no_flags().with_ack(true).with_ackno(rx_isn + 1).with_payload_size(0));
     return h;
 }
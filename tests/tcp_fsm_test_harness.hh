@@ -31,8 +31,8 @@ class TestFD : public FileDescriptor {
 
     TestRFD _recv_fd;  //!< The end of a SOCK_SEQPACKET socket pair from which TCPTestHarness reads
 
-    //! Max-sized segment plus some margin
-    static constexpr size_t MAX_RECV = TCPConfig::MAX_PAYLOAD_SIZE + TCPHeader::LENGTH + 16;
+    //! Max-sized segment for any MSS the 16-bit option can carry, with room for the header and options
+    static constexpr size_t MAX_RECV = 65535 + TCPHeader::LENGTH + TCPHeader::MAX_OPTIONS_LENGTH;
 
     //! Construct from a pair of sockets
     explicit TestFD(std::pair<FileDescriptor, TestRFD> fd_pair);
@@ -60,6 +60,7 @@ class TCPTestHarness {
   public:
     TestFdAdapter _flt{};  //!< FdAdapter mockup
     TCPConnection _fsm;    //!< The TCPConnection under test
+    size_t _mss;           //!< The largest payload the TCPConnection under test may send
 
     //! A list of test steps that passed
     std::vector<std::string> _steps_executed{};
@@ -68,7 +69,7 @@ class TCPTestHarness {
     using VecIterT = std::string::const_iterator;  //!< Alias for a const iterator to a vector of bytes
 
     //! Construct a test harness, optionally passing a configuration to the TCPConnection under test
-    explicit TCPTestHarness(const TCPConfig &c_fsm = {}) : _fsm(c_fsm) {}
+    explicit TCPTestHarness(const TCPConfig &c_fsm = {}) : _fsm(c_fsm), _mss(c_fsm.mss) {}
 
     //! construct a FIN segment and inject it into TCPConnection
     void send_fin(const WrappingInt32 seqno, const std::optional<WrappingInt32> ackno = {});
@@ -80,7 +81,9 @@ class TCPTestHarness {
     void send_rst(const WrappingInt32 seqno, const std::optional<WrappingInt32> ackno = {});
 
     //! construct a SYN segment and inject it into TCPConnection
-    void send_syn(const WrappingInt32 seqno, const std::optional<WrappingInt32> ackno = {});
+    void send_syn(const WrappingInt32 seqno,
+                  const std::optional<WrappingInt32> ackno = {},
+                  const std::optional<uint16_t> swin = {});
 
     //! construct a segment containing one byte and inject it into TCPConnection
     void send_byte(const WrappingInt32 seqno, const std::optional<WrappingInt32> ackno, const uint8_t val);
@@ -121,9 +124,11 @@ class TCPTestHarness {
     //!            seqno for the SYN.
     //! \param[in] rx_isn is the ISN of the FSM's inbound sequence. i.e. the
     //!            seqno for the SYN.
+    //! \param[in] swin is the window the peer advertises with its SYN
     static TCPTestHarness in_established(const TCPConfig &cfg,
                                          const WrappingInt32 tx_isn = WrappingInt32{0},
-                                         const WrappingInt32 rx_isn = WrappingInt32{0});
+                                         const WrappingInt32 rx_isn = WrappingInt32{0},
+                                         const std::optional<uint16_t> swin = {});
 
     //! \brief Create an FSM in CLOSE_WAIT
     //! \details SYNs have been traded, and then the machine received and ACK'd FIN.
@@ -0,0 +1,145 @@
+#include "parser.hh"
+#include "tcp_header.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+TCPHeader reparse(const string &serialized) {
+    TCPHeader parsed;
+    NetParser p{string(serialized)};
+    if (const auto res = parsed.parse(p); res != ParseResult::NoError) {
+        throw runtime_error("parse failed: " + as_string(res));
+    }
+    return parsed;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const WrappingInt32 base{static_cast<uint32_t>(rd())};
+
+        // SACK-permitted and SACK blocks survive serialize() and parse()
+        {
+            TCPHeader hdr;
+            hdr.syn = true;
+            hdr.seqno = base;
+            hdr.sack_permitted = true;
+            hdr.sack_blocks = {{base + 100, base + 200}, {base + 300, base + 400}, {base + 500, base + 600}};
+            test_err_if(hdr.data_offset() != 5 + 1 + 7,
+                        "SACK-permitted and three blocks should need eight option words");
+            const string serialized = hdr.serialize();
+            test_err_if(serialized.size() != 4 * hdr.data_offset(),
+                        "serialized header length should match data offset");
+            const TCPHeader parsed = reparse(serialized);
+            test_err_if(not parsed.sack_permitted, "SACK-permitted lost in the roundtrip");
+            test_err_if(parsed.sack_blocks != hdr.sack_blocks, "SACK blocks changed in the roundtrip");
+            test_err_if(parsed.doff != hdr.data_offset(), "parsed doff should be the serialized data offset");
+        }
+
+        // Blocks beyond what fits in the option space are not sent
+        {
+            TCPHeader hdr;
+            for (uint32_t i = 0; i < 6; i++) {
+                hdr.sack_blocks.push_back({base + 10 * i, base + 10 * i + 5});
+            }
+            TCPHeader parsed = reparse(hdr.serialize());
+            test_err_if(parsed.sack_blocks.size() != TCPHeader::MAX_SACK_BLOCKS, "expected MAX_SACK_BLOCKS blocks");
+            hdr.sack_permitted = true;
+            hdr.window_scale = 7;
+            parsed = reparse(hdr.serialize());
+            test_err_if(parsed.sack_blocks.size() != TCPHeader::MAX_SACK_BLOCKS - 1,
+                        "SACK-permitted and window scale should leave room for one block fewer");
+        }
+
+        // The window scale option survives the roundtrip, and an oversized shift is capped
+        {
+            TCPHeader hdr;
+            hdr.syn = true;
+            hdr.window_scale = 9;
+            test_err_if(hdr.data_offset() != 6, "window scale should need one option word");
+            TCPHeader parsed = reparse(hdr.serialize());
+            test_err_if(parsed.window_scale != optional<uint8_t>{9}, "window scale changed in the roundtrip");
+            hdr.window_scale = 20;
+            parsed = reparse(hdr.serialize());
+            test_err_if(parsed.window_scale != optional<uint8_t>{TCPHeader::MAX_WINDOW_SCALE},
+                        "shift should be capped");
+        }
+
+        // The MSS option survives the roundtrip, alongside the other options a SYN carries
+        {
+            TCPHeader hdr;
+            hdr.syn = true;
+            hdr.mss = 1460;
+            test_err_if(hdr.data_offset() != 6, "MSS should need one option word");
+            test_err_if(reparse(hdr.serialize()).mss != optional<uint16_t>{1460}, "MSS changed in the roundtrip");
+            hdr.mss = 65495;
+            hdr.window_scale = 7;
+            hdr.timestamp = TCPTimestamp{static_cast<uint32_t>(rd()), 0};
+            hdr.sack_permitted = true;
+            test_err_if(hdr.data_offset() != 5 + 6, "a full SYN's options should need six option words");
+            const TCPHeader parsed = reparse(hdr.serialize());
+            test_err_if(parsed.mss != hdr.mss or parsed.window_scale != hdr.window_scale or
+                            not (parsed.timestamp == hdr.timestamp) or not parsed.sack_permitted,
+                        "SYN options changed in the roundtrip");
+        }
+
+        // Timestamps survive the roundtrip, and leave room for three SACK blocks
+        {
+            TCPHeader hdr;
+            hdr.timestamp = TCPTimestamp{static_cast<uint32_t>(rd()), static_cast<uint32_t>(rd())};
+            for (uint32_t i = 0; i < TCPHeader::MAX_SACK_BLOCKS; i++) {
+                hdr.sack_blocks.push_back({base + 10 * i, base + 10 * i + 5});
+            }
+            const TCPHeader parsed = reparse(hdr.serialize());
+            test_err_if(not (parsed.timestamp == hdr.timestamp), "timestamps changed in the roundtrip");
+            test_err_if(parsed.sack_blocks.size() != 3, "timestamps should leave room for three SACK blocks");
+        }
+
+        // A header without options is unchanged
+        {
+            TCPHeader hdr;
+            hdr.seqno = base;
+            test_err_if(hdr.data_offset() != 5, "no options should mean a 20-byte header");
+            const TCPHeader parsed = reparse(hdr.serialize());
+            test_err_if(parsed.mss.has_value() or parsed.window_scale.has_value() or parsed.timestamp.has_value() or
+                            parsed.sack_permitted or not parsed.sack_blocks.empty(),
+                        "no options expected");
+        }
+
+        // Unknown options are skipped, and a malformed one ends option processing
+        {
+            TCPHeader hdr;
+            hdr.doff = 12;
+            string serialized = hdr.serialize();
+            const string options{"\x08\x0a"
+                                 "abcdefgh"  // timestamps: unknown, skipped
+                                 "\x04\x02"  // SACK-permitted
+                                 "\x01"      // NOP
+                                 "\x05\x0b"  // SACK with a length that isn't 2 + 8n: skipped whole
+                                 "123456789"
+                                 "\x01\x01"
+                                 "\x05\x30",  // runs off the end of the header: ignored
+                                 28};
+            serialized.replace(TCPHeader::LENGTH, options.size(), options);
+            const TCPHeader parsed = reparse(serialized);
+            test_err_if(not parsed.sack_permitted, "SACK-permitted after an unknown option should be parsed");
+            test_err_if(not parsed.sack_blocks.empty(), "malformed SACK options should be ignored");
+            test_err_if(parsed.doff != 12, "doff should be kept");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
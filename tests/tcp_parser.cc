@@ -198,6 +198,11 @@ int main(int argc, char **argv) {
                 tcp_hdr_copy = tcp_hdr_orig;
                 // fix up segment to remove IPv4 and TCP header extensions
                 tcp_hdr_copy.doff = 5;
+                tcp_hdr_copy.mss.reset();
+                tcp_hdr_copy.window_scale.reset();
+                tcp_hdr_copy.timestamp.reset();
+                tcp_hdr_copy.sack_permitted = false;
+                tcp_hdr_copy.sack_blocks.clear();
             }  // tcp_hdr_{orig,copy} go out of scope
 
             if (!compare_tcp_headers_nolen(tcp_seg.header(), tcp_seg_copy.header())) {
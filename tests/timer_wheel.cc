@@ -0,0 +1,107 @@
+#include "test_err_if.hh"
+#include "timer_wheel.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        // timers expire when their delay has passed, earliest first
+        {
+            TimerWheel wheel;
+            wheel.arm(1, 100);
+            wheel.arm(2, 30);
+            wheel.arm(3, 5000);
+            test_err_if(wheel.size() != 3, "expected three armed timers");
+            test_err_if(wheel.time_until_next() != 30, "expected the next timer in 30 ms");
+            test_err_if(not wheel.advance(29).empty(), "nothing should expire before 30 ms");
+            test_err_if(wheel.advance(1) != vector<TimerWheel::Key>{2}, "timer 2 should expire at 30 ms");
+            test_err_if(wheel.time_until_next() != 70, "expected the next timer in 70 ms");
+            test_err_if((wheel.advance(10000) != vector<TimerWheel::Key>{1, 3}),
+                        "timers 1 and 3 should expire in order");
+            test_err_if(wheel.size() != 0 or wheel.time_until_next().has_value(), "expected no armed timers");
+        }
+
+        // cancelling and re-arming
+        {
+            TimerWheel wheel;
+            wheel.arm(7, 50);
+            wheel.arm(8, 50);
+            wheel.cancel(7);
+            test_err_if(wheel.armed(7) or not wheel.armed(8), "timer 7 should be cancelled");
+            wheel.arm(8, 200);
+            test_err_if(not wheel.advance(100).empty(), "re-armed timer 8 shouldn't expire at its old deadline");
+            test_err_if(wheel.time_until_next() != 100, "expected timer 8 in 100 ms");
+            test_err_if(wheel.advance(100) != vector<TimerWheel::Key>{8}, "timer 8 should expire at its new deadline");
+            test_err_if(not wheel.advance(1000).empty(), "cancelled timer 7 should never expire");
+        }
+
+        // a timer beyond the span of the wheel
+        {
+            TimerWheel wheel;
+            const uint64_t far = (uint64_t{1} << (TimerWheel::SLOT_BITS * TimerWheel::LEVELS)) * 3 + 17;
+            wheel.arm(9, far);
+            wheel.arm(10, 1);
+            test_err_if(wheel.advance(1) != vector<TimerWheel::Key>{10}, "timer 10 should expire after 1 ms");
+            test_err_if(wheel.time_until_next() != far - 1, "expected the far timer's deadline");
+            test_err_if(not wheel.advance(far - 2).empty(), "the far timer shouldn't expire early");
+            test_err_if(wheel.advance(1) != vector<TimerWheel::Key>{9}, "the far timer should expire on time");
+        }
+
+        // against a simple model: random arms, cancels and advances
+        {
+            auto rd = get_random_generator();
+            TimerWheel wheel;
+            map<TimerWheel::Key, uint64_t> model{};
+            uint64_t now = 0;
+            for (unsigned int round = 0; round < 20000; round++) {
+                const TimerWheel::Key key = rd() % 64;
+                switch (rd() % 4) {
+                    case 0:
+                    case 1: {
+                        const uint64_t delay = 1 + rd() % (rd() % 8 ? 300 : 300000);
+                        wheel.arm(key, delay);
+                        model[key] = now + delay;
+                    } break;
+                    case 2:
+                        wheel.cancel(key);
+                        model.erase(key);
+                        break;
+                    default: {
+                        const uint64_t ms = rd() % (rd() % 8 ? 100 : 100000);
+                        const auto expired = wheel.advance(ms);
+                        now += ms;
+                        uint64_t last_deadline = 0;
+                        for (const auto expired_key : expired) {
+                            test_err_if(model.count(expired_key) == 0 or model.at(expired_key) > now,
+                                        "a timer expired that was not due");
+                            test_err_if(model.at(expired_key) < last_deadline, "timers expired out of order");
+                            last_deadline = model.at(expired_key);
+                            model.erase(expired_key);
+                        }
+                    }
+                }
+                optional<uint64_t> next{};
+                for (const auto &[model_key, deadline] : model) {
+                    test_err_if(deadline <= now, "a timer that was due did not expire");
+                    next = min(next.value_or(deadline - now), deadline - now);
+                }
+                test_err_if(wheel.size() != model.size(), "wheel and model disagree on the number of timers");
+                test_err_if(wheel.time_until_next() != next, "wheel and model disagree on the next deadline");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}